@@ -7,12 +7,22 @@
  * @Description: WiFi 存储模块（基于 NVS 的 WiFi 列表管理接口）
  *
  * 仅负责“存 / 取 / 删”WiFi 配置，不直接操作 WiFi 连接。
+ *
+ * NVS 中每个网络一个 key（只保存连接所需字段的紧凑记录），另有一个优先级索引；
+ * 调整顺序 / 删除只改写索引与单条记录。初始化时读取索引，在内存中建立以 SSID 为键的
+ * 哈希索引（每条约 70 字节，含连接统计，不含密码）：按 SSID 查找、查询位置 / 数量为 O(1) 且不访问 Flash，
+ * 需要完整配置时只读取对应的一条记录，遍历时逐条读取，不在堆上展开整个列表。
+ * 修改接口先写入 NVS，成功后再更新内存（写穿），失败时内存内容保持不变。
+ * 接口层仍以 wifi_config_t 交换数据，
+ * 读出的配置中仅 ssid / password / bssid_set / bssid / channel / threshold.authmode 有效。
+ * 所有接口均可在任意任务中调用。
  */
 
 #ifndef STORAGE_MODULE_H
 #define STORAGE_MODULE_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "esp_err.h"
@@ -22,13 +32,43 @@
  * @brief WiFi 存储模块配置
  *
  * - nvs_namespace : 使用的 NVS 命名空间（建议单独使用一个命名空间）；
- * - max_wifi_num  : 最多保存的 WiFi 条目数量（>0，按“最近成功连接优先”排序）。
+ * - max_wifi_num  : 最多保存的 WiFi 条目数量（1 ~ WIFI_STORAGE_MAX_NUM，按“最近成功连接优先”排序）。
  */
 typedef struct {
     const char *nvs_namespace;  ///< NVS 命名空间名（只保存字符串指针，不拷贝）
-    uint8_t     max_wifi_num;   ///< WiFi 最大保存数量（0 时内部会强制设为 1）
+    uint16_t    max_wifi_num;   ///< WiFi 最大保存数量（0 时内部会强制设为 1，超过上限时按上限处理）
 } wifi_storage_config_t;
 
+/**
+ * @brief max_wifi_num 的上限
+ *
+ * 每条网络在 NVS 中约占 3 ~ 6 个条目（32 字节 / 条目），默认 24 KB 的 nvs 分区
+ * 大约可保存 100 条，保存更多时需相应加大分区。
+ */
+#define WIFI_STORAGE_MAX_NUM 512
+
+/**
+ * @brief 单个网络的连接统计
+ *
+ * 统计只在内存中累加，由 wifi_storage_flush() 写入 NVS，掉电时可能丢失最近一部分。
+ */
+typedef struct {
+    uint32_t success_count;  ///< 成功连接（获取到 IP）次数
+    uint32_t fail_count;     ///< 连接失败次数（每次失败的尝试计一次，含原地重试）
+    uint32_t last_success;   ///< 最近一次成功连接的时间（time()，秒；设备未校时为开机后秒数；0 表示从未成功）
+    uint32_t time_to_ip_ms;  ///< 从发起连接到获取 IP 的平均耗时（最近约 64 次，ms；0 表示无数据）
+} wifi_storage_stats_t;
+
+/**
+ * @brief wifi_storage_foreach() 的回调
+ *
+ * @param config 当前网络的配置（仅在回调期间有效）
+ * @param ctx    调用方上下文
+ *
+ * @return true 继续遍历；false 停止
+ */
+typedef bool (*wifi_storage_visit_cb_t)(const wifi_config_t *config, void *ctx);
+
 /**
  * @brief WiFi 存储模块默认配置
  *
@@ -46,13 +86,15 @@ typedef struct {
  *
  * 负责：
  *  - 初始化 NVS（若空间不足或版本不兼容会自动擦除重建）；
- *  - 保存配置参数，用于后续读写 WiFi 列表。
+ *  - 保存配置参数，分配内存索引（max_wifi_num 条）并从 NVS 读取已保存 WiFi 的索引。
+ *    已保存数据损坏时按空列表继续运行，下次保存时覆盖。
  *
  * @param config 外部配置；可为 NULL，NULL 时使用 WIFI_STORAGE_DEFAULT_CONFIG。
  *
  * @return
  *  - ESP_OK                 : 成功（可重复调用，后续调用直接返回 ESP_OK）
  *  - ESP_ERR_INVALID_ARG    : 配置非法（理论上不会出现，内部已做兜底）
+ *  - ESP_ERR_NO_MEM         : 内存不足
  *  - 其它 esp_err_t         : NVS 初始化相关错误
  */
 esp_err_t wifi_storage_init(const wifi_storage_config_t *config);
@@ -64,6 +106,9 @@ esp_err_t wifi_storage_init(const wifi_storage_config_t *config);
  *  - 下标 0 为当前推荐优先尝试连接的 WiFi；
  *  - 返回数量不超过初始化时设置的 max_wifi_num。
  *
+ * 逐条从 NVS 读取，读取失败的条目被跳过。条目较多时建议使用 wifi_storage_foreach()，
+ * 避免调用方准备 max_wifi_num 大小的数组。
+ *
  * @param[out] configs    调用方提供的数组，长度需 >= max_wifi_num
  * @param[out] count_out  实际读取到的条目数量（无数据时为 0）
  *
@@ -71,9 +116,88 @@ esp_err_t wifi_storage_init(const wifi_storage_config_t *config);
  *  - ESP_OK              : 读取成功（包括无任何配置的情况）
  *  - ESP_ERR_INVALID_ARG : 参数为空
  *  - ESP_ERR_INVALID_STATE : 模块未初始化
- *  - 其它 esp_err_t      : NVS 读失败 / 数据格式异常等
+ *  - 其它 esp_err_t      : 打开 NVS 失败
+ */
+esp_err_t wifi_storage_load_all(wifi_config_t *configs, uint16_t *count_out);
+
+/**
+ * @brief 按优先级顺序逐条遍历已保存的 WiFi
+ *
+ * 每次只从 NVS 读取一条记录，回调在内部锁之外执行（回调中可以调用本模块的其它接口）。
+ * 遍历期间列表被修改时，可能跳过或重复个别条目。
+ *
+ * @param cb  回调，返回 false 时提前结束
+ * @param ctx 透传给回调的上下文
+ *
+ * @return
+ *  - ESP_OK                : 遍历完成或被回调提前结束
+ *  - ESP_ERR_INVALID_ARG   : cb 为空
+ *  - ESP_ERR_INVALID_STATE : 模块未初始化
+ *  - 其它 esp_err_t        : 打开 NVS 失败
+ */
+esp_err_t wifi_storage_foreach(wifi_storage_visit_cb_t cb, void *ctx);
+
+/**
+ * @brief 查询已保存的 WiFi 数量
+ *
+ * @param[out] count_out 条目数量
+ *
+ * @return
+ *  - ESP_OK                : 成功
+ *  - ESP_ERR_INVALID_ARG   : 参数为空
+ *  - ESP_ERR_INVALID_STATE : 模块未初始化
+ */
+esp_err_t wifi_storage_get_count(uint16_t *count_out);
+
+/**
+ * @brief 读取指定优先级位置的 SSID
+ *
+ * 只访问内存索引，不读取 NVS。
+ *
+ * @param[in]  index 位置（0 为最优先）
+ * @param[out] ssid  SSID 输出缓冲（以 '\0' 结尾，超长时截断）
+ * @param[in]  size  ssid 缓冲大小，建议 33
+ *
+ * @return
+ *  - ESP_OK                : 成功
+ *  - ESP_ERR_NOT_FOUND     : index 超出列表长度
+ *  - ESP_ERR_INVALID_ARG   : 参数为空
+ *  - ESP_ERR_INVALID_STATE : 模块未初始化
+ */
+esp_err_t wifi_storage_get_ssid_at(uint16_t index, char *ssid, size_t size);
+
+/**
+ * @brief 查询已保存 SSID 的优先级位置
+ *
+ * 通过哈希索引查找，不读取 NVS。
+ *
+ * @param[in]  ssid      要查找的 SSID（以 '\0' 结尾，区分大小写）
+ * @param[out] index_out 位置（0 为最优先）
+ *
+ * @return
+ *  - ESP_OK                : 找到
+ *  - ESP_ERR_NOT_FOUND     : 未保存该 SSID
+ *  - ESP_ERR_INVALID_ARG   : 参数为空
+ *  - ESP_ERR_INVALID_STATE : 模块未初始化
  */
-esp_err_t wifi_storage_load_all(wifi_config_t *configs, uint8_t *count_out);
+esp_err_t wifi_storage_get_index(const char *ssid, uint16_t *index_out);
+
+/**
+ * @brief 按 SSID 查找已保存的 WiFi 配置
+ *
+ * 通过哈希索引定位；out 不为 NULL 时只从 NVS 读取这一条记录，out 为 NULL 时不访问 NVS。
+ *
+ * @param[in]  ssid 要查找的 SSID（以 '\0' 结尾，区分大小写）
+ * @param[out] out  找到时写入完整配置，可为 NULL（仅判断是否存在）
+ *
+ * @return
+ *  - ESP_OK                : 找到
+ *  - ESP_ERR_NOT_FOUND     : 未保存该 SSID
+ *  - ESP_ERR_INVALID_ARG   : ssid 为空或空字符串
+ *  - ESP_ERR_INVALID_STATE : 模块未初始化
+ *  - 其它 esp_err_t        : 读取记录失败
+ */
+esp_err_t wifi_storage_find(const char *ssid, wifi_config_t *out);
 
 /**
  * @brief 在 WiFi 成功连接后更新存储列表
@@ -81,20 +205,78 @@ esp_err_t wifi_storage_load_all(wifi_config_t *configs, uint8_t *count_out);
  * 一般在“STA 成功获取 IP”事件中调用，用于维护“最近成功连接”的有序列表。
  *
  * 策略：
- *  - 已存在同名 SSID：对应条目移动到首位，保持其余顺序不变；
+ *  - 已存在同名 SSID：以 config 覆盖对应条目并移动到首位，保持其余顺序不变；
  *  - 不存在该 SSID：
  *      - 若列表未满：将该配置插入首位；
  *      - 若列表已满：将该配置插入首位并丢弃最后一条。
  *
- * @param[in] config 本次成功连接使用的 wifi_config_t（完整结构体）
+ * 除 SSID / 密码外，调用方可在 config->sta 中记录本次连接的 AP 信息作为下次的定向连接提示：
+ *  - bssid_set = true 表示提示有效，bssid / channel 为所连 AP；
+ *  - threshold.authmode 为所连 AP 的认证方式。
+ *
+ * 该网络的 SSID / 密码 / 定向连接提示都未变化时不改写其记录（已在首位时只读取、不写 NVS，
+ * 否则只改写索引），连接统计（成功次数、最近成功时间、平均获取 IP 耗时）只更新在内存中，之后由
+ * wifi_storage_flush() 保存（见 wifi_storage_has_pending()）。
+ *
+ * @param[in] config        本次成功连接使用的 wifi_config_t（完整结构体）
+ * @param[in] time_to_ip_ms 本次从发起连接到获取 IP 的耗时（ms），0 表示未测量（不计入平均值）
  *
  * @return
  *  - ESP_OK               : 更新成功
  *  - ESP_ERR_INVALID_ARG  : config 为空
  *  - ESP_ERR_INVALID_STATE: 模块未初始化
- *  - 其它 esp_err_t       : NVS 写失败等
+ *  - 其它 esp_err_t       : NVS 写失败等（此时内存中的列表保持不变）
+ */
+esp_err_t wifi_storage_on_connected(const wifi_config_t *config, uint32_t time_to_ip_ms);
+
+/**
+ * @brief 记录一次连接失败
+ *
+ * 只累加内存中的失败次数，不改变列表顺序，之后由 wifi_storage_flush() 保存。
+ *
+ * @param[in] ssid 连接失败的 SSID
+ *
+ * @return
+ *  - ESP_OK                : 成功
+ *  - ESP_ERR_NOT_FOUND     : 未保存该 SSID（不记录）
+ *  - ESP_ERR_INVALID_ARG   : ssid 为空或空字符串
+ *  - ESP_ERR_INVALID_STATE : 模块未初始化
  */
-esp_err_t wifi_storage_on_connected(const wifi_config_t *config);
+esp_err_t wifi_storage_on_failed(const char *ssid);
+
+/**
+ * @brief 读取已保存网络的连接统计
+ *
+ * 只访问内存索引，不读取 NVS，包含尚未写入 NVS 的部分。
+ *
+ * @param[in]  ssid 要查询的 SSID
+ * @param[out] out  统计数据
+ *
+ * @return
+ *  - ESP_OK                : 成功
+ *  - ESP_ERR_NOT_FOUND     : 未保存该 SSID
+ *  - ESP_ERR_INVALID_ARG   : 参数为空
+ *  - ESP_ERR_INVALID_STATE : 模块未初始化
+ */
+esp_err_t wifi_storage_get_stats(const char *ssid, wifi_storage_stats_t *out);
+
+/**
+ * @brief 将暂存在内存中的连接统计写入 NVS
+ *
+ * 没有待写入数据时直接返回。建议定期调用，以及在主动重启前调用，
+ * 掉电时最多丢失上次写入之后的统计数据（列表本身不受影响）。
+ *
+ * @return
+ *  - ESP_OK               : 成功（包括无需写入）
+ *  - ESP_ERR_INVALID_STATE: 模块未初始化
+ *  - 其它 esp_err_t       : NVS 写失败等（数据仍保留在内存中，可稍后重试）
+ */
+esp_err_t wifi_storage_flush(void);
+
+/**
+ * @brief 是否有尚未写入 NVS 的连接统计
+ */
+bool wifi_storage_has_pending(void);
 
 /**
  * @brief 按 SSID 删除已保存的 WiFi 配置
@@ -108,8 +290,43 @@ esp_err_t wifi_storage_on_connected(const wifi_config_t *config);
  *  - ESP_OK               : 删除成功（包括未找到目标时）
  *  - ESP_ERR_INVALID_ARG  : ssid 为空或空字符串
  *  - ESP_ERR_INVALID_STATE: 模块未初始化
- *  - 其它 esp_err_t       : NVS 读/写失败等
+ *  - 其它 esp_err_t       : NVS 写失败等（此时内存中的列表保持不变）
  */
 esp_err_t wifi_storage_delete_by_ssid(const char *ssid);
 
+/**
+ * @brief 批量导入 WiFi 配置（不连接）
+ *
+ * configs 按优先级排列（下标 0 最优先），SSID 重复时以先出现的为准：
+ *  - replace = true ：以导入列表替换整个已保存列表；
+ *  - replace = false：导入的网络按给定顺序排到最前，其余已保存网络保持原顺序排在其后，
+ *                     超出 max_wifi_num 的部分被丢弃。
+ *
+ * 已保存的网络保留连接统计；SSID / 密码未变且 config 未带定向连接提示时不改写其记录。
+ * 每个新增或变化的网络写入一条记录，索引只写一次（需要复用被移除网络的槽位时先多写一次
+ * 只含保留网络的索引）。
+ *
+ * 导入不是事务：NVS 对每个 key 的写入各自生效，nvs_commit 不保证多个 key 一起生效。
+ * 写入顺序保证中途失败或掉电后 NVS 中始终有一份可用的索引，列表为以下之一：
+ *  - 导入前的列表，但已保存网络中被改写的密码 / 定向连接参数可能已是新值；
+ *  - 导入前列表中保留下来的部分（复用槽位时写入的中间索引）；
+ *  - 完整的导入结果。
+ * 未被索引引用的新记录在下次初始化时清理。
+ *
+ * 导出使用 wifi_storage_foreach()，其结果按原顺序传回本函数即可恢复列表（连接统计除外）。
+ *
+ * @param[in] configs 要导入的配置数组（count 为 0 时可为 NULL）
+ * @param[in] count   条目数量，不超过 max_wifi_num
+ * @param[in] replace 是否替换整个列表
+ *
+ * @return
+ *  - ESP_OK                : 导入成功
+ *  - ESP_ERR_INVALID_ARG   : configs 为空或其中有空 SSID
+ *  - ESP_ERR_INVALID_SIZE  : count 超过 max_wifi_num
+ *  - ESP_ERR_NO_MEM        : 内存不足
+ *  - ESP_ERR_INVALID_STATE : 模块未初始化
+ *  - 其它 esp_err_t        : NVS 写失败等（内存中的列表与 NVS 中的索引保持一致）
+ */
+esp_err_t wifi_storage_import(const wifi_config_t *configs, uint16_t count, bool replace);
+
 #endif /* STORAGE_MODULE_H */
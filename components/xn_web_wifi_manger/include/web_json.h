@@ -0,0 +1,101 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2026-10-16 13:13:38
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2026-10-16 13:13:38
+ * @FilePath: \xn_web_wifi_config\components\xn_web_wifi_manger\include\web_json.h
+ * @Description: Web 模块内部使用的流式 JSON 写入器
+ *
+ * - 自动处理逗号与嵌套，字符串按 JSON 规则转义；
+ * - 响应模式：内部固定大小缓冲，写满即通过 httpd_resp_send_chunk 发出，
+ *   响应大小与缓冲大小无关，不需要堆分配；
+ * - 缓冲模式：写入调用方提供的缓冲区（如 SSE 帧），溢出时报错而不是静默截断。
+ *
+ * 任一步出错后后续写入均被忽略，错误在 web_json_finish() 统一返回。
+ */
+
+#ifndef WEB_JSON_H
+#define WEB_JSON_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+/** 响应模式下每次发送的分块大小 */
+#define WEB_JSON_CHUNK_SIZE 256
+
+/** 最大嵌套层数（对象 / 数组） */
+#define WEB_JSON_MAX_DEPTH  16
+
+/**
+ * @brief 写入器状态（放在调用方栈上即可）
+ */
+typedef struct {
+    httpd_req_t *req;                      ///< 响应模式下的请求；缓冲模式为 NULL
+    char        *buf;                      ///< 当前写入缓冲区
+    size_t       cap;                      ///< 缓冲区容量
+    size_t       len;                      ///< 缓冲区中尚未发出的字节数
+    size_t       total;                    ///< 已写入的总字节数
+    uint8_t      depth;                    ///< 当前嵌套层数
+    uint32_t     has_items;                ///< 每层是否已有元素（按位），决定是否需要逗号
+    esp_err_t    err;                      ///< 首个错误
+    char         chunk[WEB_JSON_CHUNK_SIZE]; ///< 响应模式使用的内部缓冲
+} web_json_writer_t;
+
+/**
+ * @brief 以响应模式初始化：输出以分块方式写入 HTTP 响应
+ *
+ * 调用前应先设置好响应类型等头部，第一块发出后头部即不可再修改。
+ */
+void web_json_init_resp(web_json_writer_t *w, httpd_req_t *req);
+
+/**
+ * @brief 以缓冲模式初始化：输出写入 buf，结束时以 '\0' 结尾
+ *
+ * @param buf  输出缓冲区
+ * @param size 缓冲区大小（含结尾 '\0'）
+ */
+void web_json_init_buf(web_json_writer_t *w, char *buf, size_t size);
+
+/**
+ * @brief 开始 / 结束一个对象
+ *
+ * @param key 所在对象中的键名；位于数组中或作为顶层值时传 NULL
+ */
+void web_json_obj_begin(web_json_writer_t *w, const char *key);
+void web_json_obj_end(web_json_writer_t *w);
+
+/**
+ * @brief 开始 / 结束一个数组
+ *
+ * @param key 所在对象中的键名；位于数组中或作为顶层值时传 NULL
+ */
+void web_json_arr_begin(web_json_writer_t *w, const char *key);
+void web_json_arr_end(web_json_writer_t *w);
+
+/**
+ * @brief 写入标量值（key 规则同上，字符串会被转义，val 为 NULL 时写入 null）
+ */
+void web_json_str(web_json_writer_t *w, const char *key, const char *val);
+void web_json_int(web_json_writer_t *w, const char *key, int32_t val);
+void web_json_uint(web_json_writer_t *w, const char *key, uint32_t val);
+void web_json_bool(web_json_writer_t *w, const char *key, bool val);
+
+/**
+ * @brief 结束写入
+ *
+ * - 响应模式：发出剩余数据并发送结束块；
+ * - 缓冲模式：写入结尾 '\0'，长度见 w->total。
+ *
+ * @return
+ *  - ESP_OK              : 成功
+ *  - ESP_ERR_NO_MEM      : 缓冲模式下输出超出缓冲区
+ *  - ESP_ERR_INVALID_STATE : 嵌套未闭合或超过 WEB_JSON_MAX_DEPTH
+ *  - 其它 esp_err_t      : httpd_resp_send_chunk 返回的错误
+ */
+esp_err_t web_json_finish(web_json_writer_t *w);
+
+#endif /* WEB_JSON_H */
@@ -36,7 +36,7 @@ typedef enum {
 typedef struct {
     web_wifi_status_state_t state; ///< 抽象连接状态，便于前端区分展示
     bool                    connected;        ///< 是否已成功连接路由器
-    char                    ssid[32];         ///< 当前连接的 SSID（无连接时可为 "-")
+    char                    ssid[33];         ///< 当前连接的 SSID（最长 32 字节，无连接时可为 "-")
     char                    ip[16];           ///< 当前 STA 的 IPv4 地址字符串，如 "192.168.4.2"
     int8_t                  rssi;             ///< 当前连接的信号强度（dBm），无连接时可为 0
     char                    mode[8];          ///< 当前工作模式字符串，如 "AP" / "STA" / "AP+STA"
@@ -46,14 +46,18 @@ typedef struct {
  * @brief Web 端展示用的“已保存 WiFi”精简信息
  */
 typedef struct {
-    char ssid[32]; ///< WiFi 名称（仅保留 SSID，忽略密码等敏感信息）
+    char     ssid[33];       ///< WiFi 名称（'\0' 结尾；仅保留 SSID，忽略密码等敏感信息）
+    uint32_t success_count;  ///< 成功连接次数
+    uint32_t fail_count;     ///< 连接失败次数
+    uint32_t last_success;   ///< 最近一次成功连接的时间（Unix 秒；设备未校时为开机后秒数；0 表示从未成功）
+    uint32_t time_to_ip_ms;  ///< 平均获取 IP 耗时（ms），0 表示无数据
 } web_saved_wifi_info_t;
 
 /**
  * @brief Web 端展示用的“扫描结果”精简信息
  */
 typedef struct {
-    char   ssid[32]; ///< 扫描到的 AP SSID
+    char   ssid[33]; ///< 扫描到的 AP SSID（最长 32 字节，'\0' 结尾）
     int8_t rssi;     ///< 信号强度（dBm）
 } web_scan_result_t;
 
@@ -71,20 +75,52 @@ typedef struct {
 typedef esp_err_t (*web_get_status_cb_t)(web_wifi_status_t *out_status);
 
 /**
- * @brief 获取已保存 WiFi 列表的回调
+ * @brief 逐条接收已保存 WiFi 的函数，由 Web 模块提供给 web_foreach_saved_cb_t
  *
- * @param[in,out] list      Web 模块提供的缓存数组
- * @param[in,out] inout_cnt 入口为缓存容量，出口为实际填充数量
+ * @param ctx  Web 模块的上下文，原样传回
+ * @param info 一条已保存 WiFi，仅在调用期间有效
+ *
+ * @return ESP_OK 继续；其它值表示连接已断开等错误，应停止遍历并原样返回
+ */
+typedef esp_err_t (*web_saved_visit_fn_t)(void *ctx, const web_saved_wifi_info_t *info);
+
+/**
+ * @brief 遍历已保存 WiFi 列表的回调
+ *
+ * 按优先级顺序对每个网络调用一次 visit(ctx, ...)，Web 模块直接将其写入 JSON 响应，
+ * 不需要准备数组，内存占用与列表长度无关。
  */
-typedef esp_err_t (*web_get_saved_list_cb_t)(web_saved_wifi_info_t *list, size_t *inout_cnt);
+typedef esp_err_t (*web_foreach_saved_cb_t)(web_saved_visit_fn_t visit, void *ctx);
+
+/** 请求未指定 max_age 时传给 web_scan_start_cb_t 的值，表示由上层按默认缓存策略处理 */
+#define WEB_SCAN_MAX_AGE_DEFAULT UINT32_MAX
 
 /**
- * @brief Web 模块触发一次 WiFi 扫描并获取结果的回调
+ * @brief Web 模块发起一次异步 WiFi 扫描的回调
  *
+ * 需立即返回，不等待扫描结束。实现方可返回已完成且足够新的扫描任务编号（缓存命中），
+ * 或正在进行的扫描任务编号（合并请求），不必每次都启动新的扫描。
+ *
+ * @param max_age_ms 可接受的缓存结果最大年龄（ms），0 表示需要新扫描，
+ *                   WEB_SCAN_MAX_AGE_DEFAULT 表示使用实现方的默认策略
+ * @param[out] job_id 扫描任务编号（非 0），用于之后查询结果
+ */
+typedef esp_err_t (*web_scan_start_cb_t)(uint32_t max_age_ms, uint32_t *job_id);
+
+/**
+ * @brief Web 模块按任务编号查询扫描结果的回调
+ *
+ * @param job_id            web_scan_start_cb_t 返回的任务编号
  * @param[in,out] list      Web 模块提供的缓存数组
  * @param[in,out] inout_cnt 入口为缓存容量，出口为实际填充数量
+ *
+ * @return
+ *  - ESP_OK               : 扫描已完成，结果已填充
+ *  - ESP_ERR_NOT_FINISHED : 扫描仍在进行
+ *  - ESP_ERR_NOT_FOUND    : 任务编号未知或已过期
+ *  - 其它 esp_err_t       : 扫描失败
  */
-typedef esp_err_t (*web_scan_cb_t)(web_scan_result_t *list, size_t *inout_cnt);
+typedef esp_err_t (*web_scan_result_cb_t)(uint32_t job_id, web_scan_result_t *list, size_t *inout_cnt);
 
 /**
  * @brief 删除已保存 WiFi 的回调（按 SSID 匹配）
@@ -93,14 +129,85 @@ typedef esp_err_t (*web_delete_saved_cb_t)(const char *ssid);
 
 /**
  * @brief 连接已保存 WiFi 的回调（按 SSID 匹配）
+ *
+ * 只需提交请求即可返回，不应在 HTTP 任务中执行驱动操作；连接结果通过状态推送体现。
  */
 typedef esp_err_t (*web_connect_saved_cb_t)(const char *ssid);
 
 /**
  * @brief 通过表单连接 WiFi 的回调（SSID + 密码）
+ *
+ * 要求同上：提交请求后立即返回。
  */
 typedef esp_err_t (*web_connect_cb_t)(const char *ssid, const char *password);
 
+/**
+ * @brief 文本输出函数，由 Web 模块提供给 web_metrics_cb_t
+ *
+ * @return ESP_OK 继续；其它值表示连接已断开等错误，应停止输出并原样返回
+ */
+typedef esp_err_t (*web_text_write_fn_t)(void *ctx, const char *data, size_t len);
+
+/**
+ * @brief 输出监控指标的回调（Prometheus 文本格式）
+ *
+ * 回调通过 write(ctx, ...) 逐段写出内容，Web 模块负责缓冲与分块发送。
+ */
+typedef esp_err_t (*web_metrics_cb_t)(web_text_write_fn_t write, void *ctx);
+
+/**
+ * /api/wifi/saved/import 单次请求最多包含的网络数
+ *
+ * 与存储模块上限 WIFI_STORAGE_MAX_NUM 相同，导出的完整列表总能原样导入；
+ * 实际可保存的条数仍受 save_wifi_count 限制，超出时导入回调返回 ESP_ERR_INVALID_SIZE（400）。
+ * 请求体上限按每条网络编码后的最大长度计算（SSID / 密码每字节都编码为 "%XX"）。
+ */
+#define WEB_SAVED_IMPORT_MAX_ITEMS 512
+
+/** 一条网络编码后的最大长度："ssid=" + 32×3 + "&password=" + 64×3 + "&" */
+#define WEB_SAVED_IMPORT_ITEM_MAX_LEN (5 + 32 * 3 + 10 + 64 * 3 + 1)
+
+/** /api/wifi/saved/import 请求体上限（字节，约 152 KB，流式解析，不整体缓存） */
+#define WEB_SAVED_IMPORT_MAX_BODY (WEB_SAVED_IMPORT_MAX_ITEMS * WEB_SAVED_IMPORT_ITEM_MAX_LEN)
+
+/**
+ * @brief 批量导入时的一条网络
+ */
+typedef struct {
+    char ssid[33];      ///< SSID（'\0' 结尾）
+    char password[65];  ///< 密码（'\0' 结尾，开放网络为空）
+} web_saved_import_item_t;
+
+/**
+ * @brief 批量导入已保存 WiFi 的回调
+ *
+ * 只保存，不发起连接。
+ *
+ * @param items   按优先级排列的网络（下标 0 最优先），仅在回调期间有效
+ * @param count   网络数量
+ * @param replace true 替换整个已保存列表；false 合并到列表最前
+ *
+ * @return
+ *  - ESP_OK                : 导入成功
+ *  - ESP_ERR_INVALID_ARG / ESP_ERR_INVALID_SIZE : 列表不合法（Web 模块返回 400）
+ *  - 其它 esp_err_t        : 保存失败
+ */
+typedef esp_err_t (*web_import_saved_cb_t)(const web_saved_import_item_t *items, size_t count, bool replace);
+
+/**
+ * @brief 导出时逐条输出网络的函数，由 Web 模块提供给 web_export_saved_cb_t
+ *
+ * @return ESP_OK 继续；其它值表示连接已断开等错误，应停止输出并原样返回
+ */
+typedef esp_err_t (*web_saved_emit_fn_t)(void *ctx, const char *ssid, const char *password);
+
+/**
+ * @brief 导出已保存 WiFi 的回调
+ *
+ * 按优先级顺序对每个网络调用一次 emit(ctx, ...)，Web 模块负责编码与分块发送。
+ */
+typedef esp_err_t (*web_export_saved_cb_t)(web_saved_emit_fn_t emit, void *ctx);
+
 /**
  * @brief Web 模块配置
  *
@@ -109,11 +216,15 @@ typedef esp_err_t (*web_connect_cb_t)(const char *ssid, const char *password);
 typedef struct {
     int                   http_port;        ///< HTTP 监听端口（典型为 80/8080，<=0 时使用默认 80）
     web_get_status_cb_t   get_status_cb;    ///< 查询当前 WiFi 状态回调
-    web_get_saved_list_cb_t get_saved_list_cb; ///< 获取已保存 WiFi 列表回调
-    web_scan_cb_t         scan_cb;          ///< 执行一次 WiFi 扫描并返回结果的回调
+    web_foreach_saved_cb_t foreach_saved_cb; ///< 遍历已保存 WiFi 列表的回调
+    web_scan_start_cb_t   scan_start_cb;    ///< 发起异步 WiFi 扫描的回调
+    web_scan_result_cb_t  scan_result_cb;   ///< 按任务编号查询扫描结果的回调
     web_delete_saved_cb_t delete_saved_cb;  ///< 删除已保存 WiFi 的回调
     web_connect_saved_cb_t connect_saved_cb; ///< 连接已保存 WiFi 的回调
     web_connect_cb_t      connect_cb;       ///< 通过表单连接 WiFi 的回调
+    web_metrics_cb_t      metrics_cb;       ///< 输出监控指标的回调
+    web_import_saved_cb_t import_saved_cb;  ///< 批量导入已保存 WiFi 的回调
+    web_export_saved_cb_t export_saved_cb;  ///< 导出已保存 WiFi（含密码）的回调
 } web_module_config_t;
 
 /**
@@ -123,20 +234,32 @@ typedef struct {
     (web_module_config_t){                     \
         .http_port        = 80,                \
         .get_status_cb    = NULL,              \
-        .get_saved_list_cb = NULL,             \
-        .scan_cb          = NULL,              \
+        .foreach_saved_cb = NULL,              \
+        .scan_start_cb    = NULL,              \
+        .scan_result_cb   = NULL,              \
         .delete_saved_cb  = NULL,              \
         .connect_saved_cb = NULL,              \
         .connect_cb       = NULL,              \
+        .metrics_cb       = NULL,              \
+        .import_saved_cb  = NULL,              \
+        .export_saved_cb  = NULL,              \
     }
 
 /**
  * @brief 初始化 Web 配网模块
  *
  * 负责：
- * - 挂载 SPIFFS 分区（label: "wifi_spiffs"，base_path: "/spiffs"）；
+ * - 资源模式为 SPIFFS 时挂载 SPIFFS 分区（label: "wifi_spiffs"，base_path: "/spiffs"），
+ *   嵌入固件模式（默认）下直接使用链接进镜像的资源，不挂载文件系统；
  * - 启动 HTTP 服务器并注册静态文件路由；
- * - 如配置了 get_status_cb，则注册 /api/wifi/status 接口。
+ * - 如配置了 get_status_cb，则注册 /api/wifi/status 查询接口与 /api/wifi/events 推送接口（SSE）；
+ * - 如同时配置了 scan_start_cb 与 scan_result_cb，则注册 /api/wifi/scan[?max_age=ms]
+ *   （发起扫描或复用缓存，返回任务编号）与 /api/wifi/scan/result?job=N（查询结果）接口；
+ * - 如配置了 metrics_cb，则注册 /api/metrics 接口（Prometheus 文本格式）；
+ * - 如配置了 import_saved_cb / export_saved_cb，则分别注册 POST /api/wifi/saved/import[?replace=1]
+ *   与 GET /api/wifi/saved/export 接口。两者使用相同的 application/x-www-form-urlencoded 格式
+ *   "ssid=A&password=a&ssid=B&password=b"（按优先级排列，password 可省略），导出结果可直接导入。
+ *   导出内容含明文密码，只应在受信任的网络中开放。
  *
  * @param config 配置指针，可为 NULL，NULL 时使用 WEB_MODULE_DEFAULT_CONFIG。
  *
@@ -147,5 +270,21 @@ typedef struct {
  */
 esp_err_t web_module_init(const web_module_config_t *config);
 
+/**
+ * @brief 通知 Web 模块 WiFi 状态已变化
+ *
+ * 由上层在状态变化（连接 / 断开 / 信号强度明显变化等）时调用。
+ * 若存在 /api/wifi/events 订阅者，将在 HTTP 服务器任务中通过 get_status_cb
+ * 读取最新状态并推送给所有订阅者；无订阅者时几乎没有开销。
+ *
+ * 可在任意任务中调用，多次连续调用会合并为一次推送。
+ *
+ * @return
+ *  - ESP_OK                : 已排队推送（或无需推送）
+ *  - ESP_ERR_INVALID_STATE : Web 模块尚未初始化
+ *  - 其它 esp_err_t        : 推送任务排队失败
+ */
+esp_err_t web_module_notify_status(void);
+
 #endif /* WEB_MODULE_H */
 
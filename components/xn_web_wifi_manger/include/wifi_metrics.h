@@ -0,0 +1,121 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-11-25 09:30:00
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-11-25 09:30:00
+ * @FilePath: \xn_web_wifi_config\components\xn_web_wifi_manger\include\wifi_metrics.h
+ * @Description: WiFi 连接耗时统计（按 SSID 的固定桶直方图与计数器）
+ *
+ * - 记录关联、DHCP、整次连接与掉线恢复各阶段耗时，以及连接成功 / 失败 / 掉线次数；
+ * - 直方图桶边界固定（见 WIFI_METRICS_BUCKET_BOUNDS_MS），不同固件版本的数据可直接对比；
+ * - 可通过 wifi_metrics_get() 读取，或以 Prometheus 文本格式导出（Web 端 /api/metrics）。
+ *
+ * 写入与读取均可在任意任务中调用，内部以自旋锁保护。
+ */
+
+#ifndef WIFI_METRICS_H
+#define WIFI_METRICS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+/** 直方图桶数量（最后一个桶为 +Inf） */
+#define WIFI_METRICS_BUCKET_NUM 9
+
+/** 各桶上界（ms），与 WIFI_METRICS_BUCKET_NUM - 1 个有限桶一一对应 */
+#define WIFI_METRICS_BUCKET_BOUNDS_MS { 100, 250, 500, 1000, 2000, 5000, 10000, 30000 }
+
+/**
+ * @brief 统计的连接阶段
+ */
+typedef enum {
+    WIFI_METRICS_PHASE_ASSOC = 0,   ///< 发起连接 → STA_CONNECTED
+    WIFI_METRICS_PHASE_DHCP,        ///< STA_CONNECTED → GOT_IP
+    WIFI_METRICS_PHASE_TOTAL,       ///< 发起连接 → GOT_IP
+    WIFI_METRICS_PHASE_RECOVERY,    ///< 已连接状态下掉线 → 重新 GOT_IP（含选网与失败重试）
+    WIFI_METRICS_PHASE_NUM,
+} wifi_metrics_phase_t;
+
+/**
+ * @brief 计数器
+ */
+typedef enum {
+    WIFI_METRICS_COUNTER_CONNECT_OK = 0,  ///< 连接成功（拿到 IP）
+    WIFI_METRICS_COUNTER_CONNECT_FAIL,    ///< 一次连接尝试失败
+    WIFI_METRICS_COUNTER_DISCONNECT,      ///< 已连接后掉线
+    WIFI_METRICS_COUNTER_NUM,
+} wifi_metrics_counter_t;
+
+/**
+ * @brief 单个阶段的直方图
+ */
+typedef struct {
+    uint32_t buckets[WIFI_METRICS_BUCKET_NUM]; ///< 各桶计数（非累计）
+    uint32_t count;                            ///< 样本数
+    uint64_t sum_ms;                           ///< 样本总和（ms）
+} wifi_metrics_hist_t;
+
+/**
+ * @brief 单个 SSID 的统计
+ */
+typedef struct {
+    char                ssid[33];                            ///< SSID
+    wifi_metrics_hist_t phase[WIFI_METRICS_PHASE_NUM];       ///< 各阶段耗时
+    uint32_t            counter[WIFI_METRICS_COUNTER_NUM];   ///< 各计数器
+} wifi_metrics_entry_t;
+
+/**
+ * @brief 导出时的输出回调
+ *
+ * @return ESP_OK 继续；其它值中止导出并作为 wifi_metrics_write_prometheus() 的返回值
+ */
+typedef esp_err_t (*wifi_metrics_write_fn_t)(void *ctx, const char *data, size_t len);
+
+/**
+ * @brief 初始化统计表
+ *
+ * @param max_ssids 最多统计的 SSID 数量，超出时复用最久未更新的条目
+ *
+ * @return
+ *  - ESP_OK         : 成功（重复调用直接返回 ESP_OK）
+ *  - ESP_ERR_NO_MEM : 内存不足
+ */
+esp_err_t wifi_metrics_init(size_t max_ssids);
+
+/**
+ * @brief 记录一个阶段耗时样本
+ */
+void wifi_metrics_observe(const char *ssid, wifi_metrics_phase_t phase, uint32_t ms);
+
+/**
+ * @brief 计数器加一
+ */
+void wifi_metrics_count(const char *ssid, wifi_metrics_counter_t counter);
+
+/**
+ * @brief 读取统计副本
+ *
+ * @param[out]    out       输出数组，可为 NULL（仅查询条目数）
+ * @param[in,out] inout_cnt 入口为数组容量，出口为实际条目数（out 为 NULL 时为总条目数）
+ */
+esp_err_t wifi_metrics_get(wifi_metrics_entry_t *out, size_t *inout_cnt);
+
+/**
+ * @brief 清空全部统计
+ */
+void wifi_metrics_reset(void);
+
+/**
+ * @brief 以 Prometheus 文本格式（0.0.4）导出全部统计
+ *
+ * 导出的指标：
+ * - wifi_connect_phase_seconds{ssid,phase}：histogram，phase 为 assoc / dhcp / total / recovery；
+ * - wifi_connect_total{ssid,result}：counter，result 为 ok / fail；
+ * - wifi_disconnect_total{ssid}：counter。
+ */
+esp_err_t wifi_metrics_write_prometheus(wifi_metrics_write_fn_t write, void *ctx);
+
+#endif /* WIFI_METRICS_H */
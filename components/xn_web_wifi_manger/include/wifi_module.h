@@ -9,7 +9,9 @@
  * 上层（如 wifi_manage）通过：
  *  - wifi_module_init()  配置并初始化 WiFi 驱动、STA/AP 接口；
  *  - wifi_module_connect()  发起一次 STA 连接流程；
- *  - wifi_module_scan()     执行同步扫描，获取附近 AP 列表；
+ *  - wifi_module_scan_start() / wifi_module_scan_get_results() 异步扫描，按扫描编号取结果；
+ *  - wifi_module_scan()     同步扫描（基于异步接口的阻塞封装）；
+ *  - wifi_module_get_status() 读取由事件维护的状态快照（不访问驱动）；
  * 以及注册的 event_cb 获取 WiFi 状态变化。
  */
 
@@ -20,6 +22,7 @@
 #include <stdint.h>
 
 #include "esp_err.h"
+#include "esp_wifi.h"  /* 提供 wifi_mode_t 类型 */
 
 /* -------------------------------------------------------------------------- */
 /*                               事件与回调类型                                */
@@ -36,14 +39,18 @@ typedef enum {
     WIFI_MODULE_EVENT_STA_DISCONNECTED,    ///< STA 与 AP 断开（包括主动断开和异常掉线）
     WIFI_MODULE_EVENT_STA_CONNECT_FAILED,  ///< 本次 STA 连接尝试失败（认证错误、超时等）
     WIFI_MODULE_EVENT_STA_GOT_IP,          ///< STA 成功获取 IPv4 地址，认为连接完成
+    WIFI_MODULE_EVENT_STA_RSSI_CHANGED,    ///< 周期采样发现信号强度变化达到 rssi_notify_delta
+    WIFI_MODULE_EVENT_SCAN_DONE,           ///< 异步扫描结束（成功或失败），结果可通过扫描编号读取
 } wifi_module_event_t;
 
 /**
  * @brief WiFi 模块事件回调
  *
- * @param event 当前发生的 WiFi 事件
+ * @param event  当前发生的 WiFi 事件
+ * @param reason STA_DISCONNECTED / STA_CONNECT_FAILED 时为驱动给出的断开原因（wifi_err_reason_t），
+ *               其它事件为 0
  */
-typedef void (*wifi_module_event_cb_t)(wifi_module_event_t event);
+typedef void (*wifi_module_event_cb_t)(wifi_module_event_t event, uint16_t reason);
 
 /* -------------------------------------------------------------------------- */
 /*                                   配置体                                    */
@@ -63,21 +70,86 @@ typedef struct {
     char  ap_ip[16];                        ///< AP 网关 IP（如 "192.168.4.1"）
     uint8_t ap_channel;                     ///< AP 信道（1~13，非法值由实现做修正）
     uint8_t max_sta_conn;                   ///< AP 可同时接入的 STA 数量
+    uint32_t rssi_sample_interval_ms;       ///< 已连接时 RSSI 采样周期（ms），0 表示不采样
+    uint8_t rssi_notify_delta;              ///< RSSI 变化达到该值（dBm）时上报 STA_RSSI_CHANGED
     wifi_module_event_cb_t event_cb;        ///< 事件回调，可为 NULL（不回调）
 } wifi_module_config_t;
 
+/* -------------------------------------------------------------------------- */
+/*                                  状态快照                                   */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief 最近一次连接过程各节点的时间戳（esp_timer_get_time()，us；0 表示尚未发生）
+ *
+ * 断开时不清零，供上层计算关联 / DHCP / 掉线恢复耗时。
+ */
+typedef struct {
+    int64_t connect_start_us;   ///< 最近一次发起连接（wifi_module_connect*）
+    int64_t connected_us;       ///< 最近一次 WIFI_EVENT_STA_CONNECTED
+    int64_t got_ip_us;          ///< 最近一次 IP_EVENT_STA_GOT_IP
+    int64_t disconnected_us;    ///< 最近一次 WIFI_EVENT_STA_DISCONNECTED
+} wifi_module_timing_t;
+
+/**
+ * @brief 由 WiFi / IP 事件与周期 RSSI 采样维护的 STA 状态快照
+ *
+ * 写入发生在事件循环任务与 esp_timer 任务中，读取通过 wifi_module_get_status()
+ * 获得一致的副本（顺序锁，读侧无锁、不访问驱动），可在任意任务中以常数时间调用。
+ */
+typedef struct {
+    bool        sta_connected;  ///< STA 已与 AP 建立链路
+    bool        sta_got_ip;     ///< STA 已获取 IPv4 地址
+    char        ssid[33];       ///< 当前关联 AP 的 SSID（未连接时为空串）
+    uint8_t     bssid[6];       ///< 当前关联 AP 的 BSSID
+    uint8_t     channel;        ///< 当前关联 AP 的信道
+    wifi_auth_mode_t authmode;  ///< 当前关联 AP 的认证方式
+    int8_t      rssi;           ///< 最近一次采样的 RSSI（dBm），未连接时为 0
+    char        ip[16];         ///< STA IPv4 地址字符串（未获取时为空串）
+    wifi_mode_t mode;           ///< 当前 WiFi 工作模式
+    wifi_module_timing_t timing; ///< 连接过程时间戳
+} wifi_module_status_t;
+
+/**
+ * @brief 定向连接提示：上次成功连接时记录的 AP 信息
+ *
+ * 提供后驱动只在指定信道上探测指定 BSSID，跳过全信道扫描。
+ */
+typedef struct {
+    uint8_t          bssid[6];  ///< 目标 AP 的 BSSID
+    uint8_t          channel;   ///< 目标 AP 所在信道（1~14）
+    wifi_auth_mode_t authmode;  ///< 上次观察到的认证方式，作为本次连接的最低认证要求
+} wifi_module_ap_hint_t;
+
 /* -------------------------------------------------------------------------- */
 /*                                扫描结果结构体                               */
 /* -------------------------------------------------------------------------- */
 
+/** 模块内部保存的单次扫描结果上限 */
+#define WIFI_MODULE_SCAN_MAX_RESULTS 32
+
 /**
  * @brief WiFi 扫描结果中单个 AP 信息（精简版）
  */
 typedef struct {
-    char   ssid[32];   ///< SSID（UTF-8，<=31 字符，结尾自动补 '\0'）
-    int8_t rssi;       ///< RSSI（dBm）
+    char             ssid[33];   ///< SSID（UTF-8，最长 32 字节，结尾自动补 '\0'）
+    int8_t           rssi;       ///< RSSI（dBm）
+    uint8_t          bssid[6];   ///< AP 的 BSSID
+    uint8_t          channel;    ///< AP 所在主信道
+    wifi_auth_mode_t authmode;   ///< AP 的认证方式
 } wifi_module_scan_result_t;
 
+/**
+ * @brief 扫描状态概要（供上层实现缓存 / 合并策略）
+ */
+typedef struct {
+    bool      running;      ///< 是否有扫描进行中
+    uint32_t  running_id;   ///< 进行中扫描的编号（running 为 false 时无意义）
+    uint32_t  done_id;      ///< 最近一次完成的扫描编号，0 表示尚无
+    esp_err_t done_status;  ///< 最近一次完成的扫描结果（ESP_OK 表示成功）
+    int64_t   done_time_us; ///< 最近一次完成的时间（esp_timer_get_time() 时基）
+} wifi_module_scan_info_t;
+
 /* -------------------------------------------------------------------------- */
 /*                                  默认配置                                   */
 /* -------------------------------------------------------------------------- */
@@ -97,6 +169,8 @@ typedef struct {
         .ap_ip        = "192.168.4.1",                          \
         .ap_channel   = 1,                                      \
         .max_sta_conn = 4,                                      \
+        .rssi_sample_interval_ms = 2000,                        \
+        .rssi_notify_delta       = 3,                           \
         .event_cb     = NULL,                                   \
     }
 
@@ -137,19 +211,98 @@ esp_err_t wifi_module_init(const wifi_module_config_t *config);
  */
 esp_err_t wifi_module_connect(const char *ssid, const char *password);
 
+/**
+ * @brief 携带定向提示连接指定 AP
+ *
+ * 与 wifi_module_connect() 相同，但在 hint 非 NULL 时锁定 BSSID 与信道，
+ * 省去全信道扫描（路由器重启后的重连约 1s，而非 3~4s）。
+ * AP 更换信道或 BSSID 后定向连接会失败（上报 STA_CONNECT_FAILED），
+ * 调用方应随后以普通方式重试。
+ *
+ * @param ssid     目标 AP SSID，必须非 NULL 且非空
+ * @param password 目标 AP 密码，可为 NULL/空串 表示开放网络
+ * @param hint     定向提示，可为 NULL（等同于 wifi_module_connect）
+ * @return 同 wifi_module_connect()
+ */
+esp_err_t wifi_module_connect_with_hint(const char *ssid,
+                                        const char *password,
+                                        const wifi_module_ap_hint_t *hint);
+
+/**
+ * @brief 发起一次异步扫描
+ *
+ * 立即返回，不等待扫描结束。扫描结束后模块在事件回调中取出结果并保存
+ * （最多 WIFI_MODULE_SCAN_MAX_RESULTS 条），随后上报 WIFI_MODULE_EVENT_SCAN_DONE。
+ * 同一时刻只允许一个扫描进行。
+ *
+ * @param[out] scan_id_out 本次扫描编号（递增，非 0），不可为 NULL
+ * @return
+ *      - ESP_OK                 已提交扫描
+ *      - ESP_ERR_INVALID_ARG    scan_id_out 为 NULL
+ *      - ESP_ERR_INVALID_STATE  WiFi 模块未初始化 / 未启用 STA / 已有扫描进行中
+ *      - 其它 esp_err_t         驱动返回的错误
+ */
+esp_err_t wifi_module_scan_start(uint32_t *scan_id_out);
+
+/**
+ * @brief 读取指定扫描编号的结果
+ *
+ * 模块只保留最近一次完成的扫描结果，编号被新扫描取代后不再可读。
+ *
+ * @param scan_id     wifi_module_scan_start() 返回的编号
+ * @param results     结果数组指针，不可为 NULL
+ * @param count_inout 输入：数组容量；输出：实际写入条目数（仅 ESP_OK 时更新）
+ * @return
+ *      - ESP_OK                 读取成功
+ *      - ESP_ERR_NOT_FINISHED   该扫描仍在进行
+ *      - ESP_ERR_NOT_FOUND      编号未知或已被更新的扫描取代
+ *      - ESP_ERR_INVALID_ARG    参数为 NULL 或容量为 0
+ *      - 其它 esp_err_t         该次扫描失败的原因
+ */
+esp_err_t wifi_module_scan_get_results(uint32_t scan_id,
+                                       wifi_module_scan_result_t *results,
+                                       uint16_t *count_inout);
+
+/**
+ * @brief 读取扫描状态概要
+ *
+ * 只做一次短拷贝，不访问驱动。
+ *
+ * @param[out] out 输出状态，不可为 NULL
+ * @return
+ *      - ESP_OK                 读取成功
+ *      - ESP_ERR_INVALID_ARG    out 为 NULL
+ */
+esp_err_t wifi_module_scan_get_info(wifi_module_scan_info_t *out);
+
 /**
  * @brief 同步扫描附近可见的 WiFi 列表
  *
- * 内部会发起一次阻塞式扫描，完成后将结果拷贝到调用方提供的数组中。
+ * 基于 wifi_module_scan_start() 的阻塞封装：发起扫描并等待 SCAN_DONE 后拷贝结果。
+ * 等待依赖事件循环任务，因此不可在 event_cb 等事件循环上下文中调用。
  *
  * @param results     结果数组指针，不可为 NULL
  * @param count_inout 输入：数组容量；输出：实际写入条目数
  * @return
  *      - ESP_OK                 扫描成功
  *      - ESP_ERR_INVALID_ARG    参数为 NULL 或容量为 0
- *      - ESP_ERR_INVALID_STATE  WiFi 模块未初始化
+ *      - ESP_ERR_INVALID_STATE  WiFi 模块未初始化或已有扫描进行中
+ *      - ESP_ERR_TIMEOUT        等待扫描结束超时
  *      - 其它 esp_err_t         具体错误见日志
  */
 esp_err_t wifi_module_scan(wifi_module_scan_result_t *results, uint16_t *count_inout);
 
+/**
+ * @brief 读取 STA 状态快照
+ *
+ * 快照由 WiFi / IP 事件处理函数与周期 RSSI 采样维护，本接口只做一次一致性拷贝，
+ * 不调用任何驱动 / netif 接口，也不会与事件循环任务争用锁。
+ *
+ * @param[out] out 输出快照，不可为 NULL
+ * @return
+ *      - ESP_OK                 读取成功
+ *      - ESP_ERR_INVALID_ARG    out 为 NULL
+ */
+esp_err_t wifi_module_get_status(wifi_module_status_t *out);
+
 #endif /* WIFI_MODULE_H */
@@ -16,16 +16,11 @@
 #ifndef XN_WIFI_MANAGE_H
 #define XN_WIFI_MANAGE_H
 
-#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
 
-/**
- * @brief WiFi 管理状态机单步运行周期（单位：ms）
- *
- * 管理任务会按该间隔周期性调用内部状态机：
- * - 间隔过小：状态更新更及时，但占用更多 CPU；
- * - 间隔过大：重连/轮询响应变慢。
- */
-#define WIFI_MANAGE_STEP_INTERVAL_MS 1000
+#include "esp_err.h"
+#include "esp_wifi.h"  /* 提供 wifi_config_t 类型 */
 
 /**
  * @brief WiFi 管理层抽象的连接状态
@@ -54,14 +49,29 @@ typedef void (*wifi_event_cb_t)(wifi_manage_state_t state);
  * 该结构体仅在初始化时读取一次，之后由管理模块内部持有副本。
  */
 typedef struct {
-    int  max_retry_count;          ///< 单个 AP 最多连续重试次数（<=0 表示只尝试一次）
-    int  reconnect_interval_ms;    ///< 整轮失败后等待多久再自动重试；<0 表示关闭自动重试
+    int  max_retry_count;          ///< 临时性故障（信标超时、关联失败等）时对同一 AP 原地重试的次数（<=0 表示只尝试一次）；
+                                   ///< 密码错误 / 找不到 AP 不重试
+    int  reconnect_interval_ms;    ///< 单个网络首次失败后的退避时长，之后每次失败翻倍；<0 表示关闭自动重试
+    int  reconnect_max_interval_ms; ///< 退避时长上限（ms），<=0 表示只受内部 1 小时上限约束（设置值也不超过 1 小时）；
+                                   ///< 实际等待在 [上限/2, 上限] 内随机
     char ap_ssid[32];              ///< 配网 AP SSID（最长 31 字符，需手动保证 '\0' 结尾）
     char ap_password[64];          ///< 配网 AP 密码（8~63 字符，留 1 字节给 '\0'）
     char ap_ip[16];                ///< 配网 AP 网口 IP 地址，如 "192.168.4.1"
     wifi_event_cb_t wifi_event_cb; ///< 状态变化回调，可为 NULL 表示不关心
-    int  save_wifi_count;          ///< 最多保存的 WiFi 条数（<=0 使用 1；值越大占用更多 NVS/堆内存）
+    int  save_wifi_count;          ///< 最多保存的 WiFi 条数（<=0 使用 1，上限 WIFI_STORAGE_MAX_NUM；每条约占 70 B 堆内存与 3~6 个 NVS 条目）
     int  web_port;                 ///< Web 配网页面 HTTP 监听端口（典型为 80/8080）
+    int  scan_cache_ttl_ms;        ///< 网页扫描结果缓存有效期（ms），期内的请求复用上次结果；<=0 表示不缓存
+    int  assoc_timeout_ms;         ///< 单次连接从发起到与 AP 建立链路的时限（ms），超时换下一个候选；<=0 不限时
+    int  dhcp_timeout_ms;          ///< 建立链路后获取 IP 的时限（ms），超时换下一个候选；<=0 不限时
+    int  storage_flush_delay_ms;   ///< 连接统计（成功次数等）延迟写入 NVS 的时间（ms），期内多次重连合并为一次写入；
+                                   ///< <=0 表示每次立即写入。列表顺序 / 密码变化总是立即写入
+    /* 选网打分：候选得分 = 最强 AP 的 RSSI（dBm）+ 以下各项（单位均为 dB，可为 0 表示不参与） */
+    int  rank_recency_db;          ///< 已保存列表（最近成功连接优先）中每靠前一位的加分，只计前 8 位
+    int  rank_reliability_db;      ///< 成功率为 100% 时的加分，按 成功次数 / (成功 + 失败次数) 折算
+    int  rank_experience_db;       ///< 成功次数达到 16 次时的加分，不足时按比例折算
+    int  rank_ip_time_db;          ///< 平均获取 IP 耗时每 1 秒的扣分（最多按 30 秒计）
+    bool web_saved_transfer;       ///< 是否开放 /api/wifi/saved/import 与 /api/wifi/saved/export 接口
+                                   ///< （导出内容含明文密码，默认关闭）
 } wifi_manage_config_t;
 
 /**
@@ -78,12 +88,22 @@ typedef struct {
     (wifi_manage_config_t){                                \
         .max_retry_count       = 5,                        \
         .reconnect_interval_ms = 10000,                    \
+        .reconnect_max_interval_ms = 300000,               \
         .ap_ssid               = "XN-ESP32-AP",            \
         .ap_password           = "12345678",               \
         .ap_ip                 = "192.168.4.1",            \
         .wifi_event_cb         = NULL,                     \
         .save_wifi_count       = 5,                        \
         .web_port              = 80,                       \
+        .scan_cache_ttl_ms     = 10000,                    \
+        .assoc_timeout_ms      = 15000,                    \
+        .dhcp_timeout_ms       = 15000,                    \
+        .storage_flush_delay_ms = 600000,                  \
+        .rank_recency_db       = 3,                        \
+        .rank_reliability_db   = 10,                       \
+        .rank_experience_db    = 6,                        \
+        .rank_ip_time_db       = 1,                        \
+        .web_saved_transfer    = false,                    \
     }
 
 /**
@@ -102,4 +122,25 @@ typedef struct {
  */
 esp_err_t wifi_manage_init(const wifi_manage_config_t *config);
 
+/**
+ * @brief 批量导入已保存 WiFi（只保存，不连接）
+ *
+ * 用于出厂 / 批量配网：一次写入多个网络及其优先级，不需要逐个连接成功。
+ * 导入不是事务，中途失败或掉电后的列表状态与详细规则见 wifi_storage_import()。
+ * 按优先级导出可使用 wifi_storage_foreach()，其结果按原顺序传回本函数即可恢复列表。
+ *
+ * 由管理任务串行执行，调用方阻塞等待结果；不可在 wifi_event_cb 中调用。
+ *
+ * @param configs 按优先级排列的配置（下标 0 最优先），仅 ssid / password 以及
+ *                bssid_set / bssid / channel / threshold.authmode 有效
+ * @param count   条目数量，不超过 save_wifi_count
+ * @param replace true 替换整个已保存列表；false 排到已保存列表最前（超出容量的旧条目被丢弃）
+ *
+ * @return
+ *      - ESP_OK                : 导入成功
+ *      - ESP_ERR_INVALID_STATE : 管理模块尚未初始化
+ *      - 其它 esp_err_t        : 见 wifi_storage_import()
+ */
+esp_err_t wifi_manage_import_saved(const wifi_config_t *configs, uint16_t count, bool replace);
+
 #endif /* XN_WIFI_MANAGE_H */
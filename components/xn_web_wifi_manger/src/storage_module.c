@@ -4,253 +4,1381 @@
  * @LastEditors: xingnian jixingnian@gmail.com
  * @LastEditTime: 2025-11-22 20:05:14
  * @FilePath: \xn_web_wifi_config\components\xn_web_wifi_manger\src\storage_module.c
- * @Description: WiFi 存储模块实现（基于 NVS，保存常用 WiFi 列表）
- * 
+ * @Description: WiFi 存储模块实现（基于 NVS，每个网络一个 key + 优先级索引，内存中为 SSID 哈希索引）
+ *
  * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
  */
 
-#include <stdlib.h>
-#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "nvs_flash.h"
+
+#include "storage_module.h"
+
+/* 本模块日志 TAG */
+static const char *TAG = "wifi_storage";
+
+/* -------------------- 存储格式 -------------------- */
+
+/*
+ * 每个网络单独保存在一个 key 中（"net<槽位号>"），另有一个索引 key 按优先级记录各网络的槽位号。
+ * 只保存连接所需字段，不保存 wifi_config_t 原始结构（其大小与布局随 IDF 版本变化）。
+ *
+ *   索引: magic(0x57) | version | count(u16) | slot(u16) × count
+ *   记录: magic(0x57) | version | rec_len | flags | channel | authmode | bssid[6]
+ *         | success_count(u32) | last_success(u32)
+ *         | ssid_len | ssid[ssid_len] | pass_len | password[pass_len]
+ *         | fail_count(u32) | ip_ms(u32) | ip_samples          （后加字段，旧记录中没有时按 0 处理）
+ *
+ * - 多字节整数均为小端；ssid / password 不含 '\0'；
+ * - rec_len 为其后记录内容的长度：以后在记录末尾追加字段无需改版本，旧固件按 rec_len 跳过
+ *   不认识的部分即可；只有不兼容的改动才递增 version；
+ * - 调整顺序只改写索引；删除改写索引并擦除一条记录；新增 / 更新参数 / 写入统计只改写对应记录
+ *   （新增时另需改写索引）。每次写入量与列表长度无关；
+ * - 新增时先写记录再写索引，删除时先写索引再擦除记录：中途掉电最多留下索引未引用的记录，
+ *   初始化时清理。槽位号取自 [0, max_wifi_num]，列表已满时新网络使用空闲槽位，被挤出的网络
+ *   在索引更新后再擦除；max_wifi_num 调小后超出范围的槽位在初始化时搬到范围内。
+ *
+ * 旧格式在初始化时转换后删除：
+ * - "wifi_recs"：整个列表一个 blob（头部 magic | version | count(u16)，其后为上述记录去掉
+ *   magic / version 的部分依次排列）；
+ * - "wifi_list"：wifi_config_t 数组。
+ */
+static const char *WIFI_INDEX_KEY   = "wifi_idx";
+static const char *WIFI_RECORDS_KEY = "wifi_recs";
+static const char *WIFI_LEGACY_KEY  = "wifi_list";
+
+#define WIFI_STORAGE_MAGIC        0x57
+#define WIFI_STORAGE_VERSION      1
+#define WIFI_STORAGE_HDR_SIZE     4                                  /* magic | version | count */
+#define WIFI_STORAGE_REC_FIXED    (1 + 1 + 1 + 6 + 4 + 4)           /* flags ~ last_success */
+#define WIFI_STORAGE_REC_MIN      (WIFI_STORAGE_REC_FIXED + 1 + 1)  /* 加上两个长度字节 */
+#define WIFI_STORAGE_REC_EXT      (4 + 4 + 1)                       /* fail_count | ip_ms | ip_samples */
+#define WIFI_STORAGE_REC_MAX_SIZE (1 + WIFI_STORAGE_REC_MIN + 32 + 64 + WIFI_STORAGE_REC_EXT)
+
+#define WIFI_STORAGE_FLAG_BSSID   0x01  /* bssid / channel / authmode 为有效的定向连接提示 */
+
+#define WIFI_STORAGE_NIL          0xFFFF  /* 空槽位号（哈希链结尾 / 未找到） */
+#define WIFI_STORAGE_MIN_BUCKETS  8
+#define WIFI_STORAGE_IP_WINDOW    64      /* 平均获取 IP 耗时按最近约这么多次计算 */
+
+/**
+ * @brief 一条完整记录（编解码与读写 Flash 时使用）
+ */
+typedef struct {
+    char     ssid[33];        /* SSID（'\0' 结尾） */
+    char     password[65];    /* 密码（'\0' 结尾，开放网络为空） */
+    uint8_t  flags;           /* WIFI_STORAGE_FLAG_* */
+    uint8_t  channel;         /* 上次所连 AP 的信道 */
+    uint8_t  authmode;        /* 上次所连 AP 的认证方式（wifi_auth_mode_t） */
+    uint8_t  bssid[6];        /* 上次所连 AP 的 BSSID */
+    wifi_storage_stats_t stats;  /* 连接统计 */
+    uint8_t  ip_samples;      /* stats.time_to_ip_ms 已计入的样本数（不超过 WIFI_STORAGE_IP_WINDOW） */
+} wifi_storage_entry_t;
+
+/**
+ * @brief 常驻内存的单个网络（按槽位号存放）
+ *
+ * 只保留查找与排序需要的字段，密码与定向连接提示留在 Flash 中按需读取。
+ * 统计数据以内存为准（可能尚未写入 Flash，见 dirty）。
+ */
+typedef struct {
+    char     ssid[33];        /* SSID（'\0' 结尾） */
+    bool     used;            /* 槽位是否被列表中的网络占用 */
+    bool     dirty;           /* 统计数据尚未写入 NVS */
+    uint16_t next;            /* 同一哈希桶中的下一个槽位，WIFI_STORAGE_NIL 结尾 */
+    uint16_t pos;             /* 在优先级列表中的下标 */
+    uint8_t  ip_samples;
+    wifi_storage_stats_t stats;
+} wifi_storage_node_t;
+
+/* -------------------- 模块状态 -------------------- */
+
+/* 存储模块配置与初始化标志 */
+static wifi_storage_config_t s_storage_cfg;
+static bool                  s_storage_inited = false;
+
+/*
+ * 常驻内存的索引：
+ * - s_storage_nodes 按槽位号存放各网络（max_wifi_num + 1 个槽位，多出的一个供列表已满时
+ *   新网络先写入、再擦除被挤出的网络）；
+ * - s_storage_buckets 为 SSID 哈希桶，按 SSID 查找为 O(1)；
+ * - s_storage_order 按优先级记录槽位号。修改时在 s_storage_order_work 中生成新顺序，
+ *   写入 NVS 成功后再交换并更新节点（写穿），写入失败时内存内容保持不变。
+ *
+ * 读取来自 HTTP 任务与管理任务，由 s_storage_lock 保护。
+ */
+static wifi_storage_node_t *s_storage_nodes      = NULL;
+static uint16_t            *s_storage_buckets    = NULL;
+static uint16_t             s_storage_bucket_mask = 0;
+static uint16_t            *s_storage_order      = NULL;  /* 当前顺序，容量 max_wifi_num */
+static uint16_t            *s_storage_order_work = NULL;  /* 修改时使用的工作缓冲，容量同上 */
+static uint8_t             *s_storage_blob       = NULL;  /* 编码缓冲，可容纳一条记录或满员时的索引 */
+static uint16_t             s_storage_count      = 0;     /* 当前列表条目数 */
+static SemaphoreHandle_t    s_storage_lock       = NULL;
+
+/**
+ * @brief 初始化 NVS（供存储模块使用）
+ *
+ * - 正常初始化或已初始化：返回 ESP_OK；
+ * - 如遇页面不足或版本升级：擦除整个 NVS 分区后重新初始化。
+ */
+static esp_err_t wifi_storage_init_nvs(void)
+{
+    esp_err_t ret = nvs_flash_init();
+
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        /* 全分区擦除后再初始化，防止旧格式残留 */
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+
+    return ret;
+}
+
+/* -------------------- 条目与 wifi_config_t 转换 -------------------- */
+
+static void wifi_storage_entry_from_config(wifi_storage_entry_t *e, const wifi_config_t *config)
+{
+    memset(e, 0, sizeof(*e));
+    memcpy(e->ssid, config->sta.ssid, sizeof(config->sta.ssid));
+    memcpy(e->password, config->sta.password, sizeof(config->sta.password));
+    if (config->sta.bssid_set) {
+        e->flags   |= WIFI_STORAGE_FLAG_BSSID;
+        memcpy(e->bssid, config->sta.bssid, sizeof(e->bssid));
+        e->channel  = config->sta.channel;
+        e->authmode = (uint8_t)config->sta.threshold.authmode;
+    }
+}
+
+static void wifi_storage_entry_to_config(const wifi_storage_entry_t *e, wifi_config_t *config)
+{
+    memset(config, 0, sizeof(*config));
+    memcpy(config->sta.ssid, e->ssid, sizeof(config->sta.ssid));
+    memcpy(config->sta.password, e->password, sizeof(config->sta.password));
+    if (e->flags & WIFI_STORAGE_FLAG_BSSID) {
+        config->sta.bssid_set          = true;
+        memcpy(config->sta.bssid, e->bssid, sizeof(config->sta.bssid));
+        config->sta.channel            = e->channel;
+        config->sta.threshold.authmode = (wifi_auth_mode_t)e->authmode;
+    }
+}
+
+/**
+ * @brief 两个条目的连接参数（SSID / 密码 / 定向连接提示）是否相同，不比较统计数据
+ */
+static bool wifi_storage_same_params(const wifi_storage_entry_t *a, const wifi_storage_entry_t *b)
+{
+    return strcmp(a->ssid, b->ssid) == 0 &&
+           strcmp(a->password, b->password) == 0 &&
+           a->flags == b->flags &&
+           a->channel == b->channel &&
+           a->authmode == b->authmode &&
+           memcmp(a->bssid, b->bssid, sizeof(a->bssid)) == 0;
+}
+
+/* -------------------- SSID 哈希索引 -------------------- */
+
+/**
+ * @brief SSID 的 FNV-1a 哈希（最多 32 字节）
+ */
+static uint32_t wifi_storage_hash(const char *ssid)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < 32 && ssid[i] != '\0'; ++i) {
+        h ^= (uint8_t)ssid[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * @brief 按 SSID 查找槽位（调用方需持有 s_storage_lock）
+ *
+ * @return 槽位号，未找到时返回 WIFI_STORAGE_NIL
+ */
+static uint16_t wifi_storage_lookup(const char *ssid)
+{
+    uint16_t slot = s_storage_buckets[wifi_storage_hash(ssid) & s_storage_bucket_mask];
+    while (slot != WIFI_STORAGE_NIL) {
+        if (strncmp(s_storage_nodes[slot].ssid, ssid, 32) == 0) {
+            return slot;
+        }
+        slot = s_storage_nodes[slot].next;
+    }
+    return WIFI_STORAGE_NIL;
+}
+
+/**
+ * @brief 占用槽位并加入哈希索引（不修改优先级顺序）
+ */
+static void wifi_storage_node_add(uint16_t slot, const wifi_storage_entry_t *e)
+{
+    wifi_storage_node_t *node = &s_storage_nodes[slot];
+    uint16_t            *head = &s_storage_buckets[wifi_storage_hash(e->ssid) & s_storage_bucket_mask];
+
+    memset(node, 0, sizeof(*node));
+    memcpy(node->ssid, e->ssid, sizeof(node->ssid));
+    node->used       = true;
+    node->stats      = e->stats;
+    node->ip_samples = e->ip_samples;
+    node->next       = *head;
+    *head            = slot;
+}
+
+/**
+ * @brief 释放槽位并移出哈希索引（不修改优先级顺序）
+ */
+static void wifi_storage_node_remove(uint16_t slot)
+{
+    uint16_t *link = &s_storage_buckets[wifi_storage_hash(s_storage_nodes[slot].ssid) & s_storage_bucket_mask];
+    while (*link != WIFI_STORAGE_NIL) {
+        if (*link == slot) {
+            *link = s_storage_nodes[slot].next;
+            break;
+        }
+        link = &s_storage_nodes[*link].next;
+    }
+    s_storage_nodes[slot].used  = false;
+    s_storage_nodes[slot].dirty = false;
+}
+
+/**
+ * @brief 槽位是否被列表中的网络占用（超出范围的槽位视为未占用）
+ */
+static bool wifi_storage_slot_used(uint16_t slot)
+{
+    return slot <= s_storage_cfg.max_wifi_num && s_storage_nodes[slot].used;
+}
+
+/**
+ * @brief 最小的空闲槽位号（列表最多 max_wifi_num 条，结果不超过 max_wifi_num）
+ */
+static uint16_t wifi_storage_free_slot(void)
+{
+    uint16_t slot = 0;
+    while (s_storage_nodes[slot].used) {
+        slot++;
+    }
+    return slot;
+}
+
+/**
+ * @brief 以工作缓冲中的新顺序替换当前顺序并刷新各节点的下标（调用方需持有 s_storage_lock，且已写入 NVS）
+ */
+static void wifi_storage_swap_order(uint16_t count)
+{
+    uint16_t *tmp        = s_storage_order;
+    s_storage_order      = s_storage_order_work;
+    s_storage_order_work = tmp;
+    s_storage_count      = count;
+
+    for (uint16_t i = 0; i < count; ++i) {
+        s_storage_nodes[s_storage_order[i]].pos = i;
+    }
+}
+
+/* -------------------- 编码 / 解码 -------------------- */
+
+static uint8_t *wifi_storage_put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static uint16_t wifi_storage_get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint8_t *wifi_storage_put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+static uint32_t wifi_storage_get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief 编码一条记录（rec_len 起，不含 magic / version）
+ *
+ * @return 写入结束位置
+ */
+static uint8_t *wifi_storage_encode_entry(const wifi_storage_entry_t *e, uint8_t *p)
+{
+    uint8_t  ssid_len = (uint8_t)strnlen(e->ssid, 32);
+    uint8_t  pass_len = (uint8_t)strnlen(e->password, 64);
+    uint8_t *rec_len  = p++;
+
+    *p++ = e->flags;
+    *p++ = e->channel;
+    *p++ = e->authmode;
+    memcpy(p, e->bssid, sizeof(e->bssid));
+    p += sizeof(e->bssid);
+    p = wifi_storage_put_u32(p, e->stats.success_count);
+    p = wifi_storage_put_u32(p, e->stats.last_success);
+    *p++ = ssid_len;
+    memcpy(p, e->ssid, ssid_len);
+    p += ssid_len;
+    *p++ = pass_len;
+    memcpy(p, e->password, pass_len);
+    p += pass_len;
+    p = wifi_storage_put_u32(p, e->stats.fail_count);
+    p = wifi_storage_put_u32(p, e->stats.time_to_ip_ms);
+    *p++ = e->ip_samples;
+
+    *rec_len = (uint8_t)(p - rec_len - 1);
+    return p;
+}
+
+/**
+ * @brief 解码一条记录（rec_len 起），成功时 *pp 移到记录末尾
+ *
+ * @return ESP_OK 成功；ESP_ERR_INVALID_SIZE 数据损坏
+ */
+static esp_err_t wifi_storage_decode_entry(const uint8_t **pp, const uint8_t *end, wifi_storage_entry_t *e)
+{
+    const uint8_t *p = *pp;
+
+    if (p >= end || *p < WIFI_STORAGE_REC_MIN || (size_t)(end - p - 1) < *p) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    const uint8_t *rec_end = p + 1 + *p;
+    p++;
+
+    memset(e, 0, sizeof(*e));
+    e->flags    = *p++;
+    e->channel  = *p++;
+    e->authmode = *p++;
+    memcpy(e->bssid, p, sizeof(e->bssid));
+    p += sizeof(e->bssid);
+    e->stats.success_count = wifi_storage_get_u32(p);
+    p += 4;
+    e->stats.last_success = wifi_storage_get_u32(p);
+    p += 4;
+
+    uint8_t ssid_len = *p++;
+    if (ssid_len == 0 || ssid_len > 32 || rec_end - p < ssid_len + 1) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(e->ssid, p, ssid_len);
+    p += ssid_len;
+
+    uint8_t pass_len = *p++;
+    if (pass_len > 64 || rec_end - p < pass_len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(e->password, p, pass_len);
+    p += pass_len;
+
+    if (rec_end - p >= WIFI_STORAGE_REC_EXT) {
+        e->stats.fail_count    = wifi_storage_get_u32(p);
+        e->stats.time_to_ip_ms = wifi_storage_get_u32(p + 4);
+        e->ip_samples          = p[8];
+    }
+
+    /* 跳过本版本不认识的追加字段 */
+    *pp = rec_end;
+    return ESP_OK;
+}
+
+/**
+ * @brief 检查 magic / version 头部
+ */
+static esp_err_t wifi_storage_check_header(const uint8_t *buf, size_t size, size_t min_size)
+{
+    if (size < min_size || buf[0] != WIFI_STORAGE_MAGIC) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (buf[1] != WIFI_STORAGE_VERSION) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    return ESP_OK;
+}
+
+/* -------------------- NVS 读写 -------------------- */
+
+static void wifi_storage_record_key(uint16_t slot, char *key, size_t size)
+{
+    snprintf(key, size, "net%u", (unsigned)slot);
+}
+
+/**
+ * @brief 读取一个 blob 到新申请的缓冲（调用方负责 free）
+ *
+ * @return ESP_ERR_NVS_NOT_FOUND 表示 key 不存在
+ */
+static esp_err_t wifi_storage_read_blob(nvs_handle_t handle, const char *key, uint8_t **out, size_t *size)
+{
+    *out  = NULL;
+    *size = 0;
+
+    esp_err_t ret = nvs_get_blob(handle, key, NULL, size);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (*size == 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    *out = (uint8_t *)malloc(*size);
+    if (*out == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    ret = nvs_get_blob(handle, key, *out, size);
+    if (ret != ESP_OK) {
+        free(*out);
+        *out = NULL;
+    }
+    return ret;
+}
+
+/**
+ * @brief 读取并解码槽位中的记录
+ */
+static esp_err_t wifi_storage_read_record(nvs_handle_t handle, uint16_t slot, wifi_storage_entry_t *e)
+{
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    wifi_storage_record_key(slot, key, sizeof(key));
+
+    uint8_t  buf[2 + WIFI_STORAGE_REC_MAX_SIZE + 16];  /* 允许少量追加字段 */
+    size_t   size = sizeof(buf);
+    esp_err_t ret = nvs_get_blob(handle, key, buf, &size);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = wifi_storage_check_header(buf, size, 2);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    const uint8_t *p = buf + 2;
+    return wifi_storage_decode_entry(&p, buf + size, e);
+}
+
+/**
+ * @brief 读取列表中的一个网络（调用方需持有 s_storage_lock）
+ *
+ * 密码与定向连接提示来自 Flash，统计数据以内存为准。
+ */
+static esp_err_t wifi_storage_read_node(nvs_handle_t handle, uint16_t slot, wifi_storage_entry_t *e)
+{
+    const wifi_storage_node_t *node = &s_storage_nodes[slot];
+
+    esp_err_t ret = wifi_storage_read_record(handle, slot, e);
+    if (ret == ESP_OK && strncmp(e->ssid, node->ssid, 32) != 0) {
+        ret = ESP_ERR_INVALID_STATE;   /* 记录被外部改写，与内存索引不一致 */
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "read saved network slot %u failed: %s", (unsigned)slot, esp_err_to_name(ret));
+        return ret;
+    }
+    e->stats      = node->stats;
+    e->ip_samples = node->ip_samples;
+    return ESP_OK;
+}
+
+static esp_err_t wifi_storage_open_ro(nvs_handle_t *handle)
+{
+    esp_err_t ret = nvs_open(s_storage_cfg.nvs_namespace, NVS_READONLY, handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "nvs_open(read) failed: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+static esp_err_t wifi_storage_open_rw(nvs_handle_t *handle)
+{
+    esp_err_t ret = nvs_open(s_storage_cfg.nvs_namespace, NVS_READWRITE, handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "nvs_open(write) failed: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/**
+ * @brief 前面的写入都成功时提交，然后关闭句柄
+ */
+static esp_err_t wifi_storage_commit_close(nvs_handle_t handle, esp_err_t ret)
+{
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "nvs_commit failed: %s", esp_err_to_name(ret));
+        }
+    }
+    nvs_close(handle);
+    return ret;
+}
+
+/**
+ * @brief 写入一条记录到指定槽位
+ */
+static esp_err_t wifi_storage_write_record(nvs_handle_t handle, uint16_t slot, const wifi_storage_entry_t *e)
+{
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    wifi_storage_record_key(slot, key, sizeof(key));
+
+    uint8_t *p = s_storage_blob;
+    *p++ = WIFI_STORAGE_MAGIC;
+    *p++ = WIFI_STORAGE_VERSION;
+    p    = wifi_storage_encode_entry(e, p);
+
+    esp_err_t ret = nvs_set_blob(handle, key, s_storage_blob, (size_t)(p - s_storage_blob));
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "write %s failed: %s", key, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/**
+ * @brief 擦除槽位中的记录（不存在视为成功）
+ */
+static esp_err_t wifi_storage_erase_record(nvs_handle_t handle, uint16_t slot)
+{
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    wifi_storage_record_key(slot, key, sizeof(key));
+
+    esp_err_t ret = nvs_erase_key(handle, key);
+    if (ret == ESP_ERR_NVS_NOT_FOUND) {
+        ret = ESP_OK;
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "erase %s failed: %s", key, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/**
+ * @brief 按给定顺序写入索引
+ */
+static esp_err_t wifi_storage_write_index(nvs_handle_t handle, const uint16_t *order, uint16_t count)
+{
+    uint8_t *p = s_storage_blob;
+    *p++ = WIFI_STORAGE_MAGIC;
+    *p++ = WIFI_STORAGE_VERSION;
+    p    = wifi_storage_put_u16(p, count);
+    for (uint16_t i = 0; i < count; ++i) {
+        p = wifi_storage_put_u16(p, order[i]);
+    }
+
+    esp_err_t ret = nvs_set_blob(handle, WIFI_INDEX_KEY, s_storage_blob, (size_t)(p - s_storage_blob));
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "write index failed: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/**
+ * @brief 擦除 key（不存在视为成功）
+ */
+static esp_err_t wifi_storage_erase_key(nvs_handle_t handle, const char *key)
+{
+    esp_err_t ret = nvs_erase_key(handle, key);
+    return (ret == ESP_ERR_NVS_NOT_FOUND) ? ESP_OK : ret;
+}
+
+/* -------------------- 初始化加载与旧格式迁移 -------------------- */
+
+/**
+ * @brief 将旧格式中的一条网络写入新槽位并追加到列表末尾（迁移时使用，列表已满或 SSID 重复时忽略）
+ */
+static esp_err_t wifi_storage_adopt(nvs_handle_t handle, const wifi_storage_entry_t *e)
+{
+    if (s_storage_count >= s_storage_cfg.max_wifi_num || wifi_storage_lookup(e->ssid) != WIFI_STORAGE_NIL) {
+        return ESP_OK;
+    }
+
+    uint16_t  slot = wifi_storage_free_slot();
+    esp_err_t ret  = wifi_storage_write_record(handle, slot, e);
+    if (ret == ESP_OK) {
+        wifi_storage_node_add(slot, e);
+        s_storage_order[s_storage_count++] = slot;
+    }
+    return ret;
+}
+
+/**
+ * @brief 迁移 "wifi_recs" 整表 blob
+ */
+static esp_err_t wifi_storage_migrate_records(nvs_handle_t handle, const uint8_t *buf, size_t size)
+{
+    if (wifi_storage_check_header(buf, size, WIFI_STORAGE_HDR_SIZE) != ESP_OK) {
+        return ESP_OK;   /* 无法识别，按空列表处理 */
+    }
+
+    uint16_t       count = wifi_storage_get_u16(buf + 2);
+    const uint8_t *p     = buf + WIFI_STORAGE_HDR_SIZE;
+    esp_err_t      ret   = ESP_OK;
+
+    for (uint16_t i = 0; i < count && ret == ESP_OK; ++i) {
+        wifi_storage_entry_t e;
+        if (wifi_storage_decode_entry(&p, buf + size, &e) != ESP_OK) {
+            break;   /* 保留损坏位置之前的条目 */
+        }
+        ret = wifi_storage_adopt(handle, &e);
+    }
+    return ret;
+}
+
+/**
+ * @brief 迁移旧版 wifi_config_t 数组 blob
+ *
+ * 只有与当前 sizeof(wifi_config_t) 一致时才能可靠解析；
+ * 不一致说明 blob 由布局不同的 IDF 版本写入，只能放弃。
+ */
+static esp_err_t wifi_storage_migrate_legacy(nvs_handle_t handle, const uint8_t *blob, size_t size)
+{
+    if ((size % sizeof(wifi_config_t)) != 0) {
+        ESP_LOGW(TAG, "legacy list size %u does not match wifi_config_t, dropped", (unsigned int)size);
+        return ESP_OK;
+    }
+
+    const wifi_config_t *configs = (const wifi_config_t *)blob;
+    size_t               num     = size / sizeof(wifi_config_t);
+    esp_err_t            ret     = ESP_OK;
+
+    for (size_t i = 0; i < num && ret == ESP_OK; ++i) {
+        if (configs[i].sta.ssid[0] == '\0') {
+            continue;
+        }
+        wifi_storage_entry_t e;
+        wifi_storage_entry_from_config(&e, &configs[i]);
+        ret = wifi_storage_adopt(handle, &e);
+    }
+    return ret;
+}
+
+/**
+ * @brief 按索引加载列表
+ *
+ * 槽位号超出 [0, max_wifi_num] 的网络（max_wifi_num 被调小）先占住顺序中的位置，
+ * 待其余网络都加载后再搬到空闲槽位，避免覆盖尚未读取的记录。
+ *
+ * @param[out] index     读出的原始槽位列表（调用方负责 free），用于之后清理未加载的记录
+ * @param[out] index_num 原始槽位数量
+ * @param[out] rewrite   索引与加载结果不一致（有记录缺失 / 损坏 / 被截断 / 搬移），需要重写
+ */
+static esp_err_t wifi_storage_load_index(nvs_handle_t handle, uint16_t **index, uint16_t *index_num,
+                                         bool *rewrite)
+{
+    uint8_t  *buf  = NULL;
+    size_t    size = 0;
+    esp_err_t ret  = wifi_storage_read_blob(handle, WIFI_INDEX_KEY, &buf, &size);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    ret = wifi_storage_check_header(buf, size, WIFI_STORAGE_HDR_SIZE);
+    uint16_t count = (ret == ESP_OK) ? wifi_storage_get_u16(buf + 2) : 0;
+    if (ret == ESP_OK && size < WIFI_STORAGE_HDR_SIZE + (size_t)count * 2) {
+        ret = ESP_ERR_INVALID_SIZE;
+    }
+    if (ret != ESP_OK) {
+        free(buf);
+        return ret;
+    }
+
+    *index = (uint16_t *)malloc((count + 1) * sizeof(uint16_t));
+    if (*index == NULL) {
+        free(buf);
+        return ESP_ERR_NO_MEM;
+    }
+    *index_num = count;
+
+    /* 待搬移的网络：槽位号超出范围，记录暂存于此 */
+    wifi_storage_entry_t *moved     = NULL;
+    uint16_t             *moved_pos = NULL;
+    uint16_t              moved_num = 0;
+
+    for (uint16_t i = 0; i < count; ++i) {
+        uint16_t slot = wifi_storage_get_u16(buf + WIFI_STORAGE_HDR_SIZE + i * 2);
+        (*index)[i]   = slot;
+
+        if (s_storage_count >= s_storage_cfg.max_wifi_num || wifi_storage_slot_used(slot)) {
+            *rewrite = true;   /* 超出上限（上限被调小）或重复 */
+            continue;
+        }
+
+        wifi_storage_entry_t e;
+        ret = wifi_storage_read_record(handle, slot, &e);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "saved network slot %u unreadable (%s), dropped", (unsigned)slot, esp_err_to_name(ret));
+            *rewrite = true;
+            continue;
+        }
+
+        bool duplicate = (wifi_storage_lookup(e.ssid) != WIFI_STORAGE_NIL);
+        for (uint16_t m = 0; m < moved_num && !duplicate; ++m) {
+            duplicate = (strcmp(moved[m].ssid, e.ssid) == 0);
+        }
+        if (duplicate) {
+            *rewrite = true;   /* 同一 SSID 出现两次，保留优先级较高的一条 */
+            continue;
+        }
+
+        if (slot > s_storage_cfg.max_wifi_num) {
+            if (moved == NULL) {
+                moved     = (wifi_storage_entry_t *)malloc(s_storage_cfg.max_wifi_num * sizeof(wifi_storage_entry_t));
+                moved_pos = (uint16_t *)malloc(s_storage_cfg.max_wifi_num * sizeof(uint16_t));
+                if (moved == NULL || moved_pos == NULL) {
+                    ret = ESP_ERR_NO_MEM;
+                    break;
+                }
+            }
+            moved[moved_num]     = e;
+            moved_pos[moved_num] = s_storage_count;
+            moved_num++;
+            s_storage_order[s_storage_count++] = WIFI_STORAGE_NIL;
+            *rewrite = true;
+            continue;
+        }
+
+        wifi_storage_node_add(slot, &e);
+        s_storage_order[s_storage_count++] = slot;
+    }
+    free(buf);
+
+    if (ret == ESP_ERR_NO_MEM) {
+        moved_num = 0;
+    } else {
+        ret = ESP_OK;
+    }
+
+    /* 搬移：写入空闲槽位，原记录随后作为未引用的槽位擦除 */
+    for (uint16_t m = 0; m < moved_num && ret == ESP_OK; ++m) {
+        uint16_t slot = wifi_storage_free_slot();
+        ret           = wifi_storage_write_record(handle, slot, &moved[m]);
+        if (ret == ESP_OK) {
+            wifi_storage_node_add(slot, &moved[m]);
+            s_storage_order[moved_pos[m]] = slot;
+        }
+    }
+    free(moved);
+    free(moved_pos);
+
+    /* 去掉未能放置的位置 */
+    uint16_t out = 0;
+    for (uint16_t i = 0; i < s_storage_count; ++i) {
+        if (s_storage_order[i] != WIFI_STORAGE_NIL) {
+            s_storage_order[out++] = s_storage_order[i];
+        }
+    }
+    s_storage_count = out;
+
+    return ret;
+}
+
+/**
+ * @brief 初始化时从 NVS 读取列表到常驻内存，必要时迁移旧格式并清理残留记录
+ */
+static esp_err_t wifi_storage_load_nvs(void)
+{
+    s_storage_count = 0;
+
+    /* 先以只读方式打开：命名空间不存在时不创建 */
+    nvs_handle_t handle;
+    esp_err_t    ret = nvs_open(s_storage_cfg.nvs_namespace, NVS_READONLY, &handle);
+    if (ret == ESP_ERR_NVS_NOT_FOUND) {
+        /* 命名空间不存在，理解为尚未保存过任何 WiFi */
+        return ESP_OK;
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "nvs_open(read) failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    nvs_close(handle);
+
+    ret = wifi_storage_open_rw(&handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    uint16_t *index     = NULL;
+    uint16_t  index_num = 0;
+    bool      rewrite   = false;
+
+    ret = wifi_storage_load_index(handle, &index, &index_num, &rewrite);
+    if (ret == ESP_ERR_NVS_NOT_FOUND) {
+        /* 尚无索引：依次尝试迁移旧格式，先写入全部记录与索引，最后删除旧 key */
+        const char *old_key = WIFI_RECORDS_KEY;
+        uint8_t    *blob    = NULL;
+        size_t      size    = 0;
+
+        ret = wifi_storage_read_blob(handle, old_key, &blob, &size);
+        if (ret == ESP_OK) {
+            ret = wifi_storage_migrate_records(handle, blob, size);
+        } else if (ret == ESP_ERR_NVS_NOT_FOUND) {
+            old_key = WIFI_LEGACY_KEY;
+            ret     = wifi_storage_read_blob(handle, old_key, &blob, &size);
+            if (ret == ESP_OK) {
+                ret = wifi_storage_migrate_legacy(handle, blob, size);
+            }
+        }
+        free(blob);
+
+        if (ret == ESP_ERR_NVS_NOT_FOUND) {
+            /* 未保存过列表 */
+            nvs_close(handle);
+            return ESP_OK;
+        }
+        if (ret == ESP_OK) {
+            ret = wifi_storage_write_index(handle, s_storage_order, s_storage_count);
+        }
+        if (ret == ESP_OK) {
+            ret = wifi_storage_erase_key(handle, old_key);
+        }
+        if (ret == ESP_OK) {
+            ESP_LOGI(TAG, "migrated %u saved network(s) from \"%s\"", (unsigned)s_storage_count, old_key);
+        }
+    } else if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "read index failed: %s", esp_err_to_name(ret));
+    } else {
+        if (rewrite) {
+            ret = wifi_storage_write_index(handle, s_storage_order, s_storage_count);
+        }
+        /* 清理索引不再引用的记录：被截断 / 搬移的条目，以及新增 / 删除中途掉电留下的记录 */
+        for (uint16_t i = 0; i < index_num && ret == ESP_OK; ++i) {
+            if (!wifi_storage_slot_used(index[i])) {
+                ret = wifi_storage_erase_record(handle, index[i]);
+            }
+        }
+        for (uint16_t slot = 0; slot <= s_storage_cfg.max_wifi_num && ret == ESP_OK; ++slot) {
+            if (!wifi_storage_slot_used(slot)) {
+                ret = wifi_storage_erase_record(handle, slot);
+            }
+        }
+    }
+
+    for (uint16_t i = 0; i < s_storage_count; ++i) {
+        s_storage_nodes[s_storage_order[i]].pos = i;
+    }
+
+    free(index);
+    return wifi_storage_commit_close(handle, ret);
+}
+
+/* -------------------- 对外接口 -------------------- */
+
+/**
+ * @brief 初始化 WiFi 存储模块
+ *
+ * - 可重复调用，多次调用仅第一次生效；
+ * - 若 config 为 NULL，使用 WIFI_STORAGE_DEFAULT_CONFIG；
+ * - 强制保证 1 <= max_wifi_num <= WIFI_STORAGE_MAX_NUM；
+ * - 从 NVS 读取一次索引并建立内存中的哈希索引（旧格式自动迁移）。
+ */
+esp_err_t wifi_storage_init(const wifi_storage_config_t *config)
+{
+    if (s_storage_inited) {
+        return ESP_OK;
+    }
+
+    /* 加载配置：优先使用用户配置，否则使用默认 */
+    s_storage_cfg = (config == NULL) ? WIFI_STORAGE_DEFAULT_CONFIG() : *config;
+
+    /* 防止后续申请 0 长度数组等问题 */
+    if (s_storage_cfg.max_wifi_num == 0) {
+        s_storage_cfg.max_wifi_num = 1;
+    }
+    if (s_storage_cfg.max_wifi_num > WIFI_STORAGE_MAX_NUM) {
+        ESP_LOGW(TAG, "max_wifi_num %u limited to %u",
+                 (unsigned)s_storage_cfg.max_wifi_num, (unsigned)WIFI_STORAGE_MAX_NUM);
+        s_storage_cfg.max_wifi_num = WIFI_STORAGE_MAX_NUM;
+    }
+
+    /* NVS 初始化 */
+    esp_err_t ret = wifi_storage_init_nvs();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "NVS init failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    /* 节点、哈希桶、顺序与编码缓冲 */
+    size_t max_num   = s_storage_cfg.max_wifi_num;
+    size_t buckets   = WIFI_STORAGE_MIN_BUCKETS;
+    size_t blob_size = WIFI_STORAGE_HDR_SIZE + max_num * 2;
+    while (buckets < max_num + 1) {
+        buckets <<= 1;
+    }
+    if (blob_size < 2 + WIFI_STORAGE_REC_MAX_SIZE) {
+        blob_size = 2 + WIFI_STORAGE_REC_MAX_SIZE;
+    }
+    if (s_storage_lock == NULL) {
+        s_storage_lock = xSemaphoreCreateMutex();
+    }
+    if (s_storage_nodes == NULL) {
+        s_storage_nodes      = (wifi_storage_node_t *)calloc(max_num + 1, sizeof(wifi_storage_node_t));
+        s_storage_buckets    = (uint16_t *)malloc(buckets * sizeof(uint16_t));
+        s_storage_order      = (uint16_t *)calloc(max_num, sizeof(uint16_t));
+        s_storage_order_work = (uint16_t *)calloc(max_num, sizeof(uint16_t));
+        s_storage_blob       = (uint8_t *)malloc(blob_size);
+    }
+    if (s_storage_lock == NULL || s_storage_nodes == NULL || s_storage_buckets == NULL ||
+        s_storage_order == NULL || s_storage_order_work == NULL || s_storage_blob == NULL) {
+        free(s_storage_nodes);
+        free(s_storage_buckets);
+        free(s_storage_order);
+        free(s_storage_order_work);
+        free(s_storage_blob);
+        s_storage_nodes      = NULL;
+        s_storage_buckets    = NULL;
+        s_storage_order      = NULL;
+        s_storage_order_work = NULL;
+        s_storage_blob       = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    memset(s_storage_buckets, 0xFF, buckets * sizeof(uint16_t));   /* 全部置为 WIFI_STORAGE_NIL */
+    s_storage_bucket_mask = (uint16_t)(buckets - 1);
+
+    ret = wifi_storage_load_nvs();
+    if (ret != ESP_OK) {
+        /* 加载中途出错时保留已读出的条目继续运行 */
+        ESP_LOGW(TAG, "load saved list failed (%s), %u network(s) loaded",
+                 esp_err_to_name(ret), (unsigned)s_storage_count);
+    }
+
+    s_storage_inited = true;
+    return ESP_OK;
+}
+
+/**
+ * @brief 读取所有已保存 WiFi 配置（逐条从 Flash 读取）
+ *
+ * @param configs    外部提供的数组缓冲，长度需 >= max_wifi_num
+ * @param count_out  实际读取到的数量（可能小于 max_wifi_num）
+ *
+ * @note 若当前没有任何配置，返回 ESP_OK 且 *count_out = 0；读取失败的条目被跳过。
+ */
+esp_err_t wifi_storage_load_all(wifi_config_t *configs, uint16_t *count_out)
+{
+    if (!s_storage_inited) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (configs == NULL || count_out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *count_out = 0;
+
+    xSemaphoreTake(s_storage_lock, portMAX_DELAY);
+    if (s_storage_count == 0) {
+        xSemaphoreGive(s_storage_lock);
+        return ESP_OK;
+    }
+
+    nvs_handle_t handle;
+    esp_err_t    ret = wifi_storage_open_ro(&handle);
+    if (ret == ESP_OK) {
+        uint16_t out = 0;
+        for (uint16_t i = 0; i < s_storage_count; ++i) {
+            wifi_storage_entry_t e;
+            if (wifi_storage_read_node(handle, s_storage_order[i], &e) == ESP_OK) {
+                wifi_storage_entry_to_config(&e, &configs[out++]);
+            }
+        }
+        *count_out = out;
+        nvs_close(handle);
+    }
+    xSemaphoreGive(s_storage_lock);
+
+    return ret;
+}
+
+/**
+ * @brief 逐条遍历已保存 WiFi（每次只读取一条记录，回调在锁外执行）
+ */
+esp_err_t wifi_storage_foreach(wifi_storage_visit_cb_t cb, void *ctx)
+{
+    if (!s_storage_inited) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (cb == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    nvs_handle_t handle;
+    bool         opened = false;
+    esp_err_t    ret    = ESP_OK;
+
+    for (uint16_t i = 0;; ++i) {
+        wifi_config_t        config;
+        wifi_storage_entry_t e;
+        bool                 have = false;
+
+        xSemaphoreTake(s_storage_lock, portMAX_DELAY);
+        if (i >= s_storage_count) {
+            xSemaphoreGive(s_storage_lock);
+            break;
+        }
+        if (!opened) {
+            ret    = wifi_storage_open_ro(&handle);
+            opened = (ret == ESP_OK);
+        }
+        if (opened) {
+            have = (wifi_storage_read_node(handle, s_storage_order[i], &e) == ESP_OK);
+        }
+        xSemaphoreGive(s_storage_lock);
 
-#include "esp_log.h"
-#include "nvs_flash.h"
+        if (!opened) {
+            break;
+        }
+        if (!have) {
+            continue;
+        }
+        wifi_storage_entry_to_config(&e, &config);
+        if (!cb(&config, ctx)) {
+            break;
+        }
+    }
 
-#include "storage_module.h"
+    if (opened) {
+        nvs_close(handle);
+    }
+    return ret;
+}
 
-/* 本模块日志 TAG */
-static const char *TAG = "wifi_storage";
+/**
+ * @brief 查询已保存条目数量
+ */
+esp_err_t wifi_storage_get_count(uint16_t *count_out)
+{
+    if (!s_storage_inited) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (count_out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
-/* 存储模块配置与初始化标志 */
-static wifi_storage_config_t s_storage_cfg;
-static bool                  s_storage_inited = false;
+    xSemaphoreTake(s_storage_lock, portMAX_DELAY);
+    *count_out = s_storage_count;
+    xSemaphoreGive(s_storage_lock);
 
-/* NVS 中保存 WiFi 列表使用的 key 名称 */
-static const char *WIFI_LIST_KEY = "wifi_list";
+    return ESP_OK;
+}
 
 /**
- * @brief 初始化 NVS（供存储模块使用）
- *
- * - 正常初始化或已初始化：返回 ESP_OK；
- * - 如遇页面不足或版本升级：擦除整个 NVS 分区后重新初始化。
+ * @brief 读取指定优先级位置的 SSID（内存索引，不访问 NVS）
  */
-static esp_err_t wifi_storage_init_nvs(void)
+esp_err_t wifi_storage_get_ssid_at(uint16_t index, char *ssid, size_t size)
 {
-    esp_err_t ret = nvs_flash_init();
+    if (!s_storage_inited) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (ssid == NULL || size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
-    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-        /* 全分区擦除后再初始化，防止旧格式残留 */
-        ESP_ERROR_CHECK(nvs_flash_erase());
-        ret = nvs_flash_init();
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+
+    xSemaphoreTake(s_storage_lock, portMAX_DELAY);
+    if (index < s_storage_count) {
+        snprintf(ssid, size, "%s", s_storage_nodes[s_storage_order[index]].ssid);
+        ret = ESP_OK;
     }
+    xSemaphoreGive(s_storage_lock);
 
     return ret;
 }
 
 /**
- * @brief 判断两个 wifi_config_t 是否为同一 SSID（仅比较 STA 模式）
- *
- * 使用 memcmp 比较完整 ssid 缓冲区，避免依赖 '\0' 结尾。
+ * @brief 查询 SSID 的优先级位置（哈希索引，不访问 NVS）
  */
-static bool wifi_storage_is_same_ssid(const wifi_config_t *a, const wifi_config_t *b)
+esp_err_t wifi_storage_get_index(const char *ssid, uint16_t *index_out)
 {
-    return memcmp(a->sta.ssid, b->sta.ssid, sizeof(a->sta.ssid)) == 0;
+    if (!s_storage_inited) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (ssid == NULL || ssid[0] == '\0' || index_out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(s_storage_lock, portMAX_DELAY);
+    uint16_t slot = wifi_storage_lookup(ssid);
+    if (slot != WIFI_STORAGE_NIL) {
+        *index_out = s_storage_nodes[slot].pos;
+    }
+    xSemaphoreGive(s_storage_lock);
+
+    return (slot != WIFI_STORAGE_NIL) ? ESP_OK : ESP_ERR_NOT_FOUND;
 }
 
 /**
- * @brief 初始化 WiFi 存储模块
- *
- * - 可重复调用，多次调用仅第一次生效；
- * - 若 config 为 NULL，使用 WIFI_STORAGE_DEFAULT_CONFIG；
- * - 强制保证 max_wifi_num >= 1。
+ * @brief 按 SSID 查找单条配置（哈希索引定位，需要配置内容时只读取这一条记录）
  */
-esp_err_t wifi_storage_init(const wifi_storage_config_t *config)
+esp_err_t wifi_storage_find(const char *ssid, wifi_config_t *out)
 {
-    if (s_storage_inited) {
-        return ESP_OK;
+    if (!s_storage_inited) {
+        return ESP_ERR_INVALID_STATE;
     }
-
-    /* 加载配置：优先使用用户配置，否则使用默认 */
-    s_storage_cfg = (config == NULL) ? WIFI_STORAGE_DEFAULT_CONFIG() : *config;
-
-    /* 防止后续申请 0 长度数组等问题 */
-    if (s_storage_cfg.max_wifi_num == 0) {
-        s_storage_cfg.max_wifi_num = 1;
+    if (ssid == NULL || ssid[0] == '\0') {
+        return ESP_ERR_INVALID_ARG;
     }
 
-    /* NVS 初始化 */
-    esp_err_t ret = wifi_storage_init_nvs();
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "NVS init failed: %s", esp_err_to_name(ret));
-        return ret;
+    xSemaphoreTake(s_storage_lock, portMAX_DELAY);
+
+    esp_err_t ret  = ESP_OK;
+    uint16_t  slot = wifi_storage_lookup(ssid);
+    if (slot == WIFI_STORAGE_NIL) {
+        ret = ESP_ERR_NOT_FOUND;
+    } else if (out != NULL) {
+        nvs_handle_t handle;
+        ret = wifi_storage_open_ro(&handle);
+        if (ret == ESP_OK) {
+            wifi_storage_entry_t e;
+            ret = wifi_storage_read_node(handle, slot, &e);
+            if (ret == ESP_OK) {
+                wifi_storage_entry_to_config(&e, out);
+            }
+            nvs_close(handle);
+        }
     }
 
-    s_storage_inited = true;
-    return ESP_OK;
+    xSemaphoreGive(s_storage_lock);
+    return ret;
 }
 
 /**
- * @brief 读取所有已保存 WiFi 配置
+ * @brief 在 STA 成功连接后更新 WiFi 列表
  *
- * @param configs    外部提供的数组缓冲，长度需 >= max_wifi_num
- * @param count_out  实际读取到的数量（可能小于 max_wifi_num）
+ * 策略：
+ * - 若该 SSID 已存在：用本次配置覆盖并移动到列表首位（保持其他顺序），统计数据累加；
+ * - 若不存在且列表未满：插入到首位；
+ * - 若不存在且列表已满：插入到首位并丢弃最后一个。
  *
- * @note 若当前没有任何配置，返回 ESP_OK 且 *count_out = 0。
+ * 统计：成功次数加 1、记录成功时间，time_to_ip_ms > 0 时计入平均获取 IP 耗时。
+ *
+ * 写入量：
+ * - 已在首位且连接参数未变：不写 NVS，统计数据暂存内存，由 wifi_storage_flush() 保存；
+ * - 连接参数未变但需前移：只改写索引，统计数据同样暂存；
+ * - 连接参数变化：改写该条记录（及索引）；
+ * - 新网络：写入一条记录与索引，满员时再擦除被挤出的记录。
+ * 判断连接参数是否变化需要读取一次该网络的记录。
  */
-esp_err_t wifi_storage_load_all(wifi_config_t *configs, uint8_t *count_out)
+esp_err_t wifi_storage_on_connected(const wifi_config_t *config, uint32_t time_to_ip_ms)
 {
     if (!s_storage_inited) {
         return ESP_ERR_INVALID_STATE;
     }
-    if (configs == NULL || count_out == NULL) {
+    if (config == NULL || config->sta.ssid[0] == '\0') {
         return ESP_ERR_INVALID_ARG;
     }
 
-    *count_out = 0;
+    uint16_t             max_num = s_storage_cfg.max_wifi_num;
+    wifi_storage_entry_t e;
+    wifi_storage_entry_from_config(&e, config);
+
+    xSemaphoreTake(s_storage_lock, portMAX_DELAY);
 
     nvs_handle_t handle;
-    esp_err_t    ret = nvs_open(s_storage_cfg.nvs_namespace, NVS_READONLY, &handle);
-    if (ret == ESP_ERR_NVS_NOT_FOUND) {
-        /* 命名空间不存在，理解为尚未保存过任何 WiFi */
-        return ESP_OK;
-    }
+    esp_err_t    ret = wifi_storage_open_rw(&handle);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "nvs_open(read) failed: %s", esp_err_to_name(ret));
+        xSemaphoreGive(s_storage_lock);
         return ret;
     }
 
-    /* 首先获取 blob 大小，用于计算配置数量 */
-    size_t blob_size = 0;
-    ret              = nvs_get_blob(handle, WIFI_LIST_KEY, NULL, &blob_size);
-    if (ret == ESP_ERR_NVS_NOT_FOUND) {
-        /* 未保存过列表 */
-        nvs_close(handle);
-        return ESP_OK;
+    uint16_t slot        = wifi_storage_lookup(e.ssid);
+    bool     existing    = (slot != WIFI_STORAGE_NIL);
+    bool     same_params = false;
+    if (existing) {
+        wifi_storage_entry_t old;
+        same_params  = (wifi_storage_read_node(handle, slot, &old) == ESP_OK &&
+                        wifi_storage_same_params(&e, &old));
+        e.stats      = s_storage_nodes[slot].stats;
+        e.ip_samples = s_storage_nodes[slot].ip_samples;
+    } else {
+        slot = wifi_storage_free_slot();
     }
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "nvs_get_blob(size) failed: %s", esp_err_to_name(ret));
-        nvs_close(handle);
-        return ret;
+    e.stats.success_count++;
+    e.stats.last_success = (uint32_t)time(NULL);
+    if (time_to_ip_ms > 0) {
+        /* 滑动平均：前 WIFI_STORAGE_IP_WINDOW 次为算术平均，之后每次按 1/WIFI_STORAGE_IP_WINDOW 更新 */
+        if (e.ip_samples < WIFI_STORAGE_IP_WINDOW) {
+            e.ip_samples++;
+        }
+        int64_t mean          = e.stats.time_to_ip_ms;
+        e.stats.time_to_ip_ms = (uint32_t)(mean + ((int64_t)time_to_ip_ms - mean) / e.ip_samples);
     }
 
-    /* blob_size 必须是 wifi_config_t 的整数倍，且非 0 */
-    if (blob_size == 0 || (blob_size % sizeof(wifi_config_t)) != 0) {
-        ESP_LOGE(TAG, "invalid blob size: %u", (unsigned int)blob_size);
+    if (existing && same_params && s_storage_nodes[slot].pos == 0) {
+        /* 顺序与连接参数都没有变化：仅统计数据更新，暂存内存 */
         nvs_close(handle);
-        return ESP_FAIL;
+        s_storage_nodes[slot].stats      = e.stats;
+        s_storage_nodes[slot].ip_samples = e.ip_samples;
+        s_storage_nodes[slot].dirty      = true;
+        xSemaphoreGive(s_storage_lock);
+        return ESP_OK;
     }
 
-    uint8_t max_num    = s_storage_cfg.max_wifi_num;
-    uint8_t stored_num = blob_size / sizeof(wifi_config_t);
-    uint8_t read_num   = (stored_num > max_num) ? max_num : stored_num;
-    size_t  read_size  = read_num * sizeof(wifi_config_t);
+    /* 新顺序：首位为本次网络，其后按原顺序排列其余条目（满员时丢弃最后一条） */
+    uint16_t out     = 1;
+    uint16_t dropped = WIFI_STORAGE_NIL;
+    s_storage_order_work[0] = slot;
+    for (uint16_t i = 0; i < s_storage_count; ++i) {
+        if (s_storage_order[i] == slot) {
+            continue;
+        }
+        if (out >= max_num) {
+            dropped = s_storage_order[i];
+            break;
+        }
+        s_storage_order_work[out++] = s_storage_order[i];
+    }
 
-    ret = nvs_get_blob(handle, WIFI_LIST_KEY, configs, &read_size);
-    nvs_close(handle);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "nvs_get_blob(data) failed: %s", esp_err_to_name(ret));
-        return ret;
+    if (!same_params) {
+        ret = wifi_storage_write_record(handle, slot, &e);
+    }
+    if (ret == ESP_OK) {
+        ret = wifi_storage_write_index(handle, s_storage_order_work, out);
     }
+    if (ret == ESP_OK && dropped != WIFI_STORAGE_NIL) {
+        ret = wifi_storage_erase_record(handle, dropped);
+    }
+    ret = wifi_storage_commit_close(handle, ret);
 
-    *count_out = read_num;
-    return ESP_OK;
+    if (ret == ESP_OK) {
+        if (dropped != WIFI_STORAGE_NIL) {
+            wifi_storage_node_remove(dropped);
+        }
+        if (!existing) {
+            wifi_storage_node_add(slot, &e);
+        }
+        s_storage_nodes[slot].stats      = e.stats;
+        s_storage_nodes[slot].ip_samples = e.ip_samples;
+        s_storage_nodes[slot].dirty      = same_params;   /* 参数未变时未改写记录，统计数据暂存 */
+        wifi_storage_swap_order(out);
+    }
+    xSemaphoreGive(s_storage_lock);
+
+    return ret;
 }
 
 /**
- * @brief 在 STA 成功连接后更新 WiFi 列表
- *
- * 策略：
- * - 若该 SSID 已存在：移动到列表首位（保持其他顺序）；
- * - 若不存在且列表未满：插入到首位；
- * - 若不存在且列表已满：插入到首位并丢弃最后一个。
+ * @brief 记录一次连接失败（只更新内存，由 wifi_storage_flush() 保存）
  */
-esp_err_t wifi_storage_on_connected(const wifi_config_t *config)
+esp_err_t wifi_storage_on_failed(const char *ssid)
 {
     if (!s_storage_inited) {
         return ESP_ERR_INVALID_STATE;
     }
-    if (config == NULL) {
+    if (ssid == NULL || ssid[0] == '\0') {
         return ESP_ERR_INVALID_ARG;
     }
 
-    uint8_t max_num = s_storage_cfg.max_wifi_num;
-    if (max_num == 0) {
-        max_num = 1;
+    xSemaphoreTake(s_storage_lock, portMAX_DELAY);
+    uint16_t slot = wifi_storage_lookup(ssid);
+    if (slot != WIFI_STORAGE_NIL) {
+        wifi_storage_node_t *node = &s_storage_nodes[slot];
+        if (node->stats.fail_count < UINT32_MAX) {
+            node->stats.fail_count++;
+        }
+        node->dirty = true;
     }
+    xSemaphoreGive(s_storage_lock);
 
-    /* 分配工作缓冲，用于读写列表 */
-    wifi_config_t *list = (wifi_config_t *)calloc(max_num, sizeof(wifi_config_t));
-    if (list == NULL) {
-        return ESP_ERR_NO_MEM;
+    return (slot != WIFI_STORAGE_NIL) ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+/**
+ * @brief 读取某个网络的连接统计（内存索引，不访问 NVS）
+ */
+esp_err_t wifi_storage_get_stats(const char *ssid, wifi_storage_stats_t *out)
+{
+    if (!s_storage_inited) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (ssid == NULL || ssid[0] == '\0' || out == NULL) {
+        return ESP_ERR_INVALID_ARG;
     }
 
-    uint8_t   count = 0;
-    esp_err_t ret   = wifi_storage_load_all(list, &count);
-    if (ret != ESP_OK) {
-        free(list);
-        return ret;
+    xSemaphoreTake(s_storage_lock, portMAX_DELAY);
+    uint16_t slot = wifi_storage_lookup(ssid);
+    if (slot != WIFI_STORAGE_NIL) {
+        *out = s_storage_nodes[slot].stats;
     }
+    xSemaphoreGive(s_storage_lock);
 
-    /* 查找是否已存在相同 SSID */
-    int existing_index = -1;
-    for (uint8_t i = 0; i < count; ++i) {
-        if (wifi_storage_is_same_ssid(&list[i], config)) {
-            existing_index = (int)i;
-            break;
-        }
+    return (slot != WIFI_STORAGE_NIL) ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+/**
+ * @brief 将暂存在内存中的统计数据写入 NVS（只改写有变化的记录）
+ */
+esp_err_t wifi_storage_flush(void)
+{
+    if (!s_storage_inited) {
+        return ESP_ERR_INVALID_STATE;
     }
 
-    if (existing_index >= 0) {
-        /* 已存在：移动到首位 */
-        if (existing_index > 0) {
-            wifi_config_t tmp = list[existing_index];
-            memmove(&list[1], &list[0], existing_index * sizeof(wifi_config_t));
-            list[0] = tmp;
+    xSemaphoreTake(s_storage_lock, portMAX_DELAY);
+
+    esp_err_t    ret = ESP_OK;
+    nvs_handle_t handle;
+    bool         opened = false;
+
+    for (uint16_t i = 0; i < s_storage_count && ret == ESP_OK; ++i) {
+        uint16_t slot = s_storage_order[i];
+        if (!s_storage_nodes[slot].dirty) {
+            continue;
         }
-    } else {
-        /* 不存在：插入到首位（可能挤掉最后一个） */
-        if (count < max_num) {
-            if (count > 0) {
-                memmove(&list[1], &list[0], count * sizeof(wifi_config_t));
+        if (!opened) {
+            ret = wifi_storage_open_rw(&handle);
+            if (ret != ESP_OK) {
+                break;
             }
-            list[0] = *config;
-            count++;
-        } else {
-            if (max_num > 1) {
-                memmove(&list[1], &list[0], (max_num - 1) * sizeof(wifi_config_t));
-            }
-            list[0] = *config;
-            count   = max_num;
+            opened = true;
         }
-    }
 
-    /* 写回 NVS */
-    nvs_handle_t handle;
-    ret = nvs_open(s_storage_cfg.nvs_namespace, NVS_READWRITE, &handle);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "nvs_open(write) failed: %s", esp_err_to_name(ret));
-        free(list);
-        return ret;
+        wifi_storage_entry_t e;
+        if (wifi_storage_read_node(handle, slot, &e) != ESP_OK) {
+            /* 记录不可读，无法重写，放弃这条统计数据 */
+            s_storage_nodes[slot].dirty = false;
+            continue;
+        }
+        ret = wifi_storage_write_record(handle, slot, &e);
+        if (ret == ESP_OK) {
+            s_storage_nodes[slot].dirty = false;
+        }
+    }
+    if (opened) {
+        ret = wifi_storage_commit_close(handle, ret);
     }
 
-    size_t blob_size = count * sizeof(wifi_config_t);
-    ret              = nvs_set_blob(handle, WIFI_LIST_KEY, list, blob_size);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "nvs_set_blob(write) failed: %s", esp_err_to_name(ret));
-        nvs_close(handle);
-        free(list);
-        return ret;
+    xSemaphoreGive(s_storage_lock);
+    return ret;
+}
+
+/**
+ * @brief 是否有尚未写入 NVS 的统计数据
+ */
+bool wifi_storage_has_pending(void)
+{
+    if (!s_storage_inited) {
+        return false;
     }
 
-    ret = nvs_commit(handle);
-    nvs_close(handle);
-    free(list);
+    bool pending = false;
 
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "nvs_commit(write) failed: %s", esp_err_to_name(ret));
-        return ret;
+    xSemaphoreTake(s_storage_lock, portMAX_DELAY);
+    for (uint16_t i = 0; i < s_storage_count && !pending; ++i) {
+        pending = s_storage_nodes[s_storage_order[i]].dirty;
     }
+    xSemaphoreGive(s_storage_lock);
 
-    return ESP_OK;
+    return pending;
 }
 
 /**
@@ -258,7 +1386,7 @@ esp_err_t wifi_storage_on_connected(const wifi_config_t *config)
  *
  * @param ssid  需要删除的 SSID 字符串（以 '\0' 结尾）
  *
- * 若删除后列表为空，则直接擦除 WIFI_LIST_KEY。
+ * 只改写索引并擦除该网络的记录。
  */
 esp_err_t wifi_storage_delete_by_ssid(const char *ssid)
 {
@@ -269,83 +1397,216 @@ esp_err_t wifi_storage_delete_by_ssid(const char *ssid)
         return ESP_ERR_INVALID_ARG;
     }
 
-    uint8_t max_num = s_storage_cfg.max_wifi_num;
-    if (max_num == 0) {
-        max_num = 1;
+    xSemaphoreTake(s_storage_lock, portMAX_DELAY);
+
+    uint16_t slot = wifi_storage_lookup(ssid);
+    if (slot == WIFI_STORAGE_NIL) {
+        /* 未找到目标，无需写入 */
+        xSemaphoreGive(s_storage_lock);
+        return ESP_OK;
     }
 
-    wifi_config_t *list = (wifi_config_t *)calloc(max_num, sizeof(wifi_config_t));
-    if (list == NULL) {
-        return ESP_ERR_NO_MEM;
+    /* 过滤出保留的条目 */
+    uint16_t out = 0;
+    for (uint16_t i = 0; i < s_storage_count; ++i) {
+        if (s_storage_order[i] != slot) {
+            s_storage_order_work[out++] = s_storage_order[i];
+        }
     }
 
-    uint8_t   count = 0;
-    esp_err_t ret   = wifi_storage_load_all(list, &count);
-    if (ret != ESP_OK) {
-        free(list);
-        return ret;
+    nvs_handle_t handle;
+    esp_err_t    ret = wifi_storage_open_rw(&handle);
+    if (ret == ESP_OK) {
+        ret = wifi_storage_write_index(handle, s_storage_order_work, out);
+        if (ret == ESP_OK) {
+            ret = wifi_storage_erase_record(handle, slot);
+        }
+        ret = wifi_storage_commit_close(handle, ret);
+    }
+
+    if (ret == ESP_OK) {
+        wifi_storage_node_remove(slot);
+        wifi_storage_swap_order(out);
     }
+    xSemaphoreGive(s_storage_lock);
 
-    if (count == 0) {
-        free(list);
+    return ret;
+}
+
+/**
+ * @brief 批量导入 WiFi 配置
+ *
+ * 1. 生成新顺序：导入的网络在前，合并模式下其后为未被导入覆盖的原有网络；
+ * 2. 为新网络分配槽位：优先使用当前未被占用的槽位，不够时复用被移除网络的槽位；
+ * 3. 写入：需要复用槽位时先写入只含保留网络的索引（被覆盖的记录不再被引用），
+ *    再写入新增 / 变化的记录与新索引，最后擦除未复用的被移除记录。
+ *
+ * taken[] 标记各槽位在新列表中的用途：0 不在新列表中，1 原有网络，2 新网络。
+ */
+esp_err_t wifi_storage_import(const wifi_config_t *configs, uint16_t count, bool replace)
+{
+    if (!s_storage_inited) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (configs == NULL && count > 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (count > s_storage_cfg.max_wifi_num) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    for (uint16_t i = 0; i < count; ++i) {
+        if (configs[i].sta.ssid[0] == '\0') {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    if (count == 0 && !replace) {
         return ESP_OK;
     }
 
-    /* 构造一个只设置 SSID 的临时配置，复用比较函数 */
-    wifi_config_t target;
-    memset(&target, 0, sizeof(target));
-    strncpy((char *)target.sta.ssid, ssid, sizeof(target.sta.ssid) - 1);
+    uint16_t  max_num = s_storage_cfg.max_wifi_num;
+    uint16_t *src     = (uint16_t *)malloc(2 * max_num * sizeof(uint16_t) + max_num + 1);
+    if (src == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    uint16_t *kept  = src + max_num;                 /* 保留下来的原有网络（原顺序） */
+    uint8_t  *taken = (uint8_t *)(kept + max_num);
+    memset(taken, 0, max_num + 1);
 
-    /* 过滤出保留的条目 */
-    uint8_t write_idx = 0;
-    for (uint8_t i = 0; i < count; ++i) {
-        if (wifi_storage_is_same_ssid(&list[i], &target)) {
-            /* 跳过待删除条目 */
+    xSemaphoreTake(s_storage_lock, portMAX_DELAY);
+
+    /* 1. 新顺序（src[k] 为第 k 位对应的 configs 下标，新网络的槽位暂记为 NIL） */
+    uint16_t out = 0;
+    for (uint16_t i = 0; i < count; ++i) {
+        const char *ssid = (const char *)configs[i].sta.ssid;
+        bool        dup  = false;
+        for (uint16_t k = 0; k < out && !dup; ++k) {
+            dup = (strncmp(ssid, (const char *)configs[src[k]].sta.ssid, 32) == 0);
+        }
+        if (dup) {
             continue;
         }
-        if (write_idx != i) {
-            list[write_idx] = list[i];
+        uint16_t slot = wifi_storage_lookup(ssid);
+        if (slot != WIFI_STORAGE_NIL) {
+            taken[slot] = 1;
+        }
+        s_storage_order_work[out] = slot;
+        src[out++]                = i;
+    }
+    uint16_t imported = out;
+    if (!replace) {
+        for (uint16_t i = 0; i < s_storage_count && out < max_num; ++i) {
+            uint16_t slot = s_storage_order[i];
+            if (!taken[slot]) {
+                taken[slot]                 = 1;
+                s_storage_order_work[out++] = slot;
+            }
         }
-        write_idx++;
     }
 
-    nvs_handle_t handle;
-    ret = nvs_open(s_storage_cfg.nvs_namespace, NVS_READWRITE, &handle);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "nvs_open(delete) failed: %s", esp_err_to_name(ret));
-        free(list);
-        return ret;
+    uint16_t kept_num = 0;
+    for (uint16_t i = 0; i < s_storage_count; ++i) {
+        if (taken[s_storage_order[i]]) {
+            kept[kept_num++] = s_storage_order[i];
+        }
     }
 
-    if (write_idx == 0) {
-        /* 已无任何配置：擦除 key */
-        ret = nvs_erase_key(handle, WIFI_LIST_KEY);
-        if (ret != ESP_OK && ret != ESP_ERR_NVS_NOT_FOUND) {
-            ESP_LOGE(TAG, "nvs_erase_key failed: %s", esp_err_to_name(ret));
-            nvs_close(handle);
-            free(list);
-            return ret;
+    /* 2. 分配槽位 */
+    bool     reuse     = false;
+    uint16_t next_free = 0;
+    uint16_t next_drop = 0;
+    for (uint16_t k = 0; k < imported; ++k) {
+        if (s_storage_order_work[k] != WIFI_STORAGE_NIL) {
+            continue;
         }
-    } else {
-        /* 仍有剩余配置：回写精简后的列表 */
-        size_t blob_size = write_idx * sizeof(wifi_config_t);
-        ret              = nvs_set_blob(handle, WIFI_LIST_KEY, list, blob_size);
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "nvs_set_blob(delete) failed: %s", esp_err_to_name(ret));
-            nvs_close(handle);
-            free(list);
-            return ret;
+        while (next_free <= max_num && (s_storage_nodes[next_free].used || taken[next_free])) {
+            next_free++;
+        }
+        uint16_t slot;
+        if (next_free <= max_num) {
+            slot = next_free;
+        } else {
+            while (!s_storage_nodes[next_drop].used || taken[next_drop]) {
+                next_drop++;
+            }
+            slot  = next_drop;
+            reuse = true;
         }
+        taken[slot]             = 2;
+        s_storage_order_work[k] = slot;
     }
 
-    ret = nvs_commit(handle);
-    nvs_close(handle);
-    free(list);
+    /* 3. 写入 */
+    nvs_handle_t handle;
+    bool         shrunk  = false;   /* NVS 中的索引已是保留列表 */
+    bool         indexed = false;   /* NVS 中的索引已是新列表 */
+    esp_err_t    ret     = wifi_storage_open_rw(&handle);
+    if (ret == ESP_OK) {
+        if (reuse) {
+            ret    = wifi_storage_write_index(handle, kept, kept_num);
+            shrunk = (ret == ESP_OK);
+        }
+        for (uint16_t k = 0; k < imported && ret == ESP_OK; ++k) {
+            uint16_t             slot = s_storage_order_work[k];
+            wifi_storage_entry_t e;
+            wifi_storage_entry_from_config(&e, &configs[src[k]]);
+            if (taken[slot] == 1) {
+                /* 原有网络：保留统计；密码未变且未带新的定向连接提示时沿用原记录 */
+                wifi_storage_entry_t old;
+                if (wifi_storage_read_node(handle, slot, &old) == ESP_OK &&
+                    strcmp(e.password, old.password) == 0 &&
+                    (!(e.flags & WIFI_STORAGE_FLAG_BSSID) || wifi_storage_same_params(&e, &old))) {
+                    continue;
+                }
+                e.stats      = s_storage_nodes[slot].stats;
+                e.ip_samples = s_storage_nodes[slot].ip_samples;
+            }
+            ret = wifi_storage_write_record(handle, slot, &e);
+            if (ret == ESP_OK && taken[slot] == 1) {
+                s_storage_nodes[slot].dirty = false;
+            }
+        }
+        if (ret == ESP_OK) {
+            ret     = wifi_storage_write_index(handle, s_storage_order_work, out);
+            indexed = (ret == ESP_OK);
+        }
+        for (uint16_t i = 0; i < s_storage_count && indexed; ++i) {
+            if (!taken[s_storage_order[i]]) {
+                /* 擦除失败时记录不再被索引引用，初始化时清理 */
+                (void)wifi_storage_erase_record(handle, s_storage_order[i]);
+            }
+        }
+        ret = wifi_storage_commit_close(handle, ret);
+    }
 
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "nvs_commit(delete) failed: %s", esp_err_to_name(ret));
-        return ret;
+    /* 内存中的列表跟随 NVS 中实际生效的索引 */
+    if (indexed || shrunk) {
+        for (uint16_t i = 0; i < s_storage_count; ++i) {
+            if (taken[s_storage_order[i]] != 1) {
+                wifi_storage_node_remove(s_storage_order[i]);
+            }
+        }
+    }
+    if (indexed) {
+        for (uint16_t k = 0; k < imported; ++k) {
+            uint16_t slot = s_storage_order_work[k];
+            if (taken[slot] == 2) {
+                wifi_storage_entry_t e;
+                wifi_storage_entry_from_config(&e, &configs[src[k]]);
+                wifi_storage_node_add(slot, &e);
+            }
+        }
+        wifi_storage_swap_order(out);
+    } else if (shrunk) {
+        memcpy(s_storage_order_work, kept, kept_num * sizeof(uint16_t));
+        wifi_storage_swap_order(kept_num);
     }
+    uint16_t saved = s_storage_count;
+    xSemaphoreGive(s_storage_lock);
 
-    return ESP_OK;
+    free(src);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "imported %u wifi (%s), %u saved", (unsigned)imported,
+                 replace ? "replace" : "merge", (unsigned)saved);
+    }
+    return ret;
 }
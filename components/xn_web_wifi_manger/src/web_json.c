@@ -0,0 +1,258 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2026-10-16 13:13:38
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2026-10-16 13:13:38
+ * @FilePath: \xn_web_wifi_config\components\xn_web_wifi_manger\src\web_json.c
+ * @Description: 流式 JSON 写入器实现
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "web_json.h"
+
+/* -------------------- 底层输出 -------------------- */
+
+/**
+ * @brief 发出缓冲区中的数据（仅响应模式）
+ */
+static void web_json_flush(web_json_writer_t *w)
+{
+    if (w->err != ESP_OK || w->len == 0) {
+        return;
+    }
+
+    esp_err_t ret = httpd_resp_send_chunk(w->req, w->buf, (ssize_t)w->len);
+    if (ret != ESP_OK) {
+        w->err = ret;
+    }
+    w->len = 0;
+}
+
+/**
+ * @brief 追加原始字节（不转义）
+ */
+static void web_json_put(web_json_writer_t *w, const char *data, size_t n)
+{
+    while (n > 0 && w->err == ESP_OK) {
+        size_t room = w->cap - w->len;
+
+        if (room == 0) {
+            if (w->req == NULL) {
+                w->err = ESP_ERR_NO_MEM;
+                return;
+            }
+            web_json_flush(w);
+            continue;
+        }
+
+        size_t step = (n < room) ? n : room;
+        memcpy(w->buf + w->len, data, step);
+        w->len   += step;
+        w->total += step;
+        data     += step;
+        n        -= step;
+    }
+}
+
+static void web_json_putc(web_json_writer_t *w, char c)
+{
+    web_json_put(w, &c, 1);
+}
+
+/**
+ * @brief 写入十进制无符号整数（避免每个数字字段都走一次 snprintf）
+ */
+static void web_json_put_u32(web_json_writer_t *w, uint32_t val)
+{
+    char  num[10];
+    char *p = num + sizeof(num);
+
+    do {
+        *--p = (char)('0' + val % 10U);
+        val /= 10U;
+    } while (val != 0);
+
+    web_json_put(w, p, (size_t)(num + sizeof(num) - p));
+}
+
+/**
+ * @brief 写入带引号的字符串，按 JSON 规则转义 '"'、'\\' 与控制字符
+ *
+ * 非 ASCII 字节（UTF-8 SSID）原样输出。
+ */
+static void web_json_put_string(web_json_writer_t *w, const char *s)
+{
+    web_json_putc(w, '"');
+
+    const char *run = s;   /* 尚未写出的无需转义片段起点 */
+    for (; *s != '\0'; s++) {
+        unsigned char c = (unsigned char)*s;
+        char          esc[7];
+        size_t        esc_len = 0;
+
+        switch (c) {
+        case '"':  esc_len = 2; memcpy(esc, "\\\"", 2); break;
+        case '\\': esc_len = 2; memcpy(esc, "\\\\", 2); break;
+        case '\n': esc_len = 2; memcpy(esc, "\\n", 2);  break;
+        case '\r': esc_len = 2; memcpy(esc, "\\r", 2);  break;
+        case '\t': esc_len = 2; memcpy(esc, "\\t", 2);  break;
+        default:
+            if (c < 0x20) {
+                esc_len = (size_t)snprintf(esc, sizeof(esc), "\\u%04x", c);
+            }
+            break;
+        }
+
+        if (esc_len > 0) {
+            web_json_put(w, run, (size_t)(s - run));
+            web_json_put(w, esc, esc_len);
+            run = s + 1;
+        }
+    }
+    web_json_put(w, run, (size_t)(s - run));
+
+    web_json_putc(w, '"');
+}
+
+/**
+ * @brief 写入值之前的分隔符与键名
+ */
+static void web_json_prefix(web_json_writer_t *w, const char *key)
+{
+    uint32_t bit = 1UL << w->depth;
+
+    if (w->has_items & bit) {
+        web_json_putc(w, ',');
+    }
+    w->has_items |= bit;
+
+    if (key != NULL) {
+        web_json_put_string(w, key);
+        web_json_putc(w, ':');
+    }
+}
+
+/**
+ * @brief 进入 / 退出一层嵌套
+ */
+static void web_json_open(web_json_writer_t *w, const char *key, char bracket)
+{
+    web_json_prefix(w, key);
+    web_json_putc(w, bracket);
+
+    if (w->depth + 1 >= WEB_JSON_MAX_DEPTH) {
+        w->err = ESP_ERR_INVALID_STATE;
+        return;
+    }
+    w->depth++;
+    w->has_items &= ~(1UL << w->depth);
+}
+
+static void web_json_close(web_json_writer_t *w, char bracket)
+{
+    if (w->depth == 0) {
+        w->err = ESP_ERR_INVALID_STATE;
+        return;
+    }
+    w->depth--;
+    web_json_putc(w, bracket);
+}
+
+/* -------------------- 对外接口 -------------------- */
+
+void web_json_init_resp(web_json_writer_t *w, httpd_req_t *req)
+{
+    memset(w, 0, offsetof(web_json_writer_t, chunk));
+    w->req = req;
+    w->buf = w->chunk;
+    w->cap = sizeof(w->chunk);
+    w->err = ESP_OK;
+}
+
+void web_json_init_buf(web_json_writer_t *w, char *buf, size_t size)
+{
+    memset(w, 0, offsetof(web_json_writer_t, chunk));
+    w->buf = (size > 0) ? buf : NULL;
+    w->cap = (size > 0) ? size - 1 : 0;   /* 预留结尾 '\0' */
+    w->err = (buf != NULL && size > 0) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+void web_json_obj_begin(web_json_writer_t *w, const char *key)
+{
+    web_json_open(w, key, '{');
+}
+
+void web_json_obj_end(web_json_writer_t *w)
+{
+    web_json_close(w, '}');
+}
+
+void web_json_arr_begin(web_json_writer_t *w, const char *key)
+{
+    web_json_open(w, key, '[');
+}
+
+void web_json_arr_end(web_json_writer_t *w)
+{
+    web_json_close(w, ']');
+}
+
+void web_json_str(web_json_writer_t *w, const char *key, const char *val)
+{
+    web_json_prefix(w, key);
+    if (val == NULL) {
+        web_json_put(w, "null", 4);
+    } else {
+        web_json_put_string(w, val);
+    }
+}
+
+void web_json_int(web_json_writer_t *w, const char *key, int32_t val)
+{
+    web_json_prefix(w, key);
+    if (val < 0) {
+        web_json_putc(w, '-');
+        web_json_put_u32(w, 0U - (uint32_t)val);
+    } else {
+        web_json_put_u32(w, (uint32_t)val);
+    }
+}
+
+void web_json_uint(web_json_writer_t *w, const char *key, uint32_t val)
+{
+    web_json_prefix(w, key);
+    web_json_put_u32(w, val);
+}
+
+void web_json_bool(web_json_writer_t *w, const char *key, bool val)
+{
+    web_json_prefix(w, key);
+    if (val) {
+        web_json_put(w, "true", 4);
+    } else {
+        web_json_put(w, "false", 5);
+    }
+}
+
+esp_err_t web_json_finish(web_json_writer_t *w)
+{
+    if (w->err == ESP_OK && w->depth != 0) {
+        w->err = ESP_ERR_INVALID_STATE;
+    }
+
+    if (w->req == NULL) {
+        /* 缓冲模式：cap 已预留结尾 '\0' 的位置 */
+        if (w->buf != NULL) {
+            w->buf[w->len] = '\0';
+        }
+        return w->err;
+    }
+
+    web_json_flush(w);
+    if (w->err == ESP_OK) {
+        w->err = httpd_resp_send_chunk(w->req, NULL, 0);
+    }
+    return w->err;
+}
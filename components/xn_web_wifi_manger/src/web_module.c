@@ -4,11 +4,11 @@
  * @LastEditors: xingnian jixingnian@gmail.com
  * @LastEditTime: 2025-11-23 11:39:20
  * @FilePath: \xn_web_wifi_config\components\xn_web_wifi_manger\src\web_module.c
- * @Description: Web 配网模块实现（HTTP 服务器 + SPIFFS 静态资源）
+ * @Description: Web 配网模块实现（HTTP 服务器 + 静态网页资源）
  *
  * 仅负责：
- *  - 挂载 SPIFFS 分区并暴露静态网页资源；
- *  - 根据回调提供简单的状态查询接口；
+ *  - 暴露静态网页资源（嵌入固件 / 分区内存映射 / SPIFFS 分区，见 Kconfig）；
+ *  - 根据回调提供简单的状态查询接口，并通过 SSE 推送状态变化；
  *
  * 不直接依赖 WiFi / 存储模块，由上层通过回调注入所需能力。
  */
@@ -17,12 +17,20 @@
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <unistd.h>
 
+#include "sdkconfig.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_spiffs.h"
+#include "esp_partition.h"
 #include "esp_http_server.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 #include "web_module.h"
+#include "web_json.h"
+#include "web_assets_gen.h" /* 构建期生成：各资源内容哈希 */
 
 /* 日志 TAG */
 static const char *TAG = "web_module";
@@ -86,6 +94,263 @@ static void web_url_decode_inplace(char *str)
     *dst = '\0';
 }
 
+/* 查询参数编码前的最大长度：64 字节密码每字节都编码为 "%XX" */
+#define WEB_QUERY_VALUE_RAW_MAX (64 * 3 + 1)
+
+/* 容纳 "ssid=<32×3>&password=<64×3>" 的查询字符串 */
+#define WEB_QUERY_CREDENTIALS_MAX (5 + 32 * 3 + 10 + 64 * 3 + 1)
+#define WEB_QUERY_SSID_MAX        (5 + 32 * 3 + 1)
+
+/**
+ * @brief 读取一个查询参数并 URL 解码，解码后的长度须小于 out_size
+ *
+ * 先按编码前的最大长度读取再解码，避免 "%E4%B8%AD" 之类的多字节 SSID 在解码前被截断。
+ *
+ * @return
+ *      - ESP_OK               成功
+ *      - ESP_ERR_NOT_FOUND    参数不存在
+ *      - ESP_ERR_INVALID_SIZE 参数过长
+ */
+static esp_err_t web_query_get_decoded(const char *query, const char *key, char *out, size_t out_size)
+{
+    char raw[WEB_QUERY_VALUE_RAW_MAX];
+
+    esp_err_t ret = httpd_query_key_value(query, key, raw, sizeof(raw));
+    if (ret == ESP_ERR_HTTPD_RESULT_TRUNC) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (ret != ESP_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    web_url_decode_inplace(raw);
+
+    size_t len = strlen(raw);
+    if (len >= out_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(out, raw, len + 1);
+    return ESP_OK;
+}
+
+/**
+ * @brief 读取查询字符串中的 ssid 参数（解码后 1~32 字节）
+ *
+ * 失败时已发送 400 响应。
+ */
+static bool web_query_get_ssid(httpd_req_t *req, const char *query, char ssid[33])
+{
+    esp_err_t ret = web_query_get_decoded(query, "ssid", ssid, 33);
+
+    if (ret == ESP_ERR_INVALID_SIZE) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "ssid too long");
+        return false;
+    }
+    if (ret != ESP_OK || ssid[0] == '\0') {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "missing ssid");
+        return false;
+    }
+    return true;
+}
+
+/* -------------------- 静态资源表 -------------------- */
+
+/**
+ * @brief 网页静态资源文件
+ *
+ * 每个资源都有原始与 gzip 预压缩两个版本（构建期由 tools/gen_web_assets.py 生成），
+ * 并带有内容哈希 hash，用作 ETag 与 URL 指纹（index.html 以 "app.css?v=<hash>" 引用资源）。
+ */
+typedef enum {
+    WEB_ASSET_INDEX_HTML = 0,
+    WEB_ASSET_APP_CSS,
+    WEB_ASSET_APP_JS,
+    WEB_ASSET_COUNT,
+} web_asset_id_t;
+
+typedef struct {
+    const char *name;         ///< 资源文件名，如 "app.css"
+    const char *content_type; ///< Content-Type 头部值
+    const char *hash;         ///< 内容哈希（16 位十六进制，不含引号）
+    bool        immutable;    ///< 通过带指纹 URL 访问时是否允许长期缓存
+} web_asset_file_t;
+
+/* 主页面始终需要重新验证，CSS/JS 可长期缓存 */
+static const web_asset_file_t s_web_asset_files[WEB_ASSET_COUNT] = {
+    [WEB_ASSET_INDEX_HTML] = { "index.html", "text/html",              WEB_ASSET_INDEX_HTML_HASH, false },
+    [WEB_ASSET_APP_CSS]    = { "app.css",    "text/css",               WEB_ASSET_APP_CSS_HASH,    true  },
+    [WEB_ASSET_APP_JS]     = { "app.js",     "application/javascript", WEB_ASSET_APP_JS_HASH,     true  },
+};
+
+/**
+ * @brief URI 路由到资源文件的映射（根路径与 /index.html 指向同一份主页面）
+ */
+typedef struct {
+    const char     *uri; ///< 访问路径，如 "/app.css"
+    web_asset_id_t  id;  ///< 对应的资源文件
+} web_asset_route_t;
+
+static const web_asset_route_t s_web_asset_routes[] = {
+    { "/",           WEB_ASSET_INDEX_HTML },
+    { "/index.html", WEB_ASSET_INDEX_HTML },
+    { "/app.css",    WEB_ASSET_APP_CSS    },
+    { "/app.js",     WEB_ASSET_APP_JS     },
+};
+
+/* 带指纹 URL 的缓存策略：内容哈希变化即 URL 变化，因此可视为永不过期 */
+#define WEB_CACHE_IMMUTABLE "public, max-age=31536000, immutable"
+
+#if CONFIG_XN_WEB_WIFI_ASSETS_EMBED || CONFIG_XN_WEB_WIFI_ASSETS_PARTITION
+/**
+ * @brief 一段可直接发送的资源数据（位于 Flash 映射区，只读）
+ */
+typedef struct {
+    const uint8_t *data; ///< 数据起始地址
+    size_t         len;  ///< 数据长度（字节）
+} web_asset_blob_t;
+
+/* 下标 [资源][0: 原始, 1: gzip] */
+static web_asset_blob_t s_web_asset_blobs[WEB_ASSET_COUNT][2];
+#endif
+
+#if CONFIG_XN_WEB_WIFI_ASSETS_EMBED
+/* -------------------- 嵌入固件资源 -------------------- */
+
+/* 由组件 CMakeLists.txt 中的 target_add_binary_data 生成的链接符号 */
+extern const uint8_t index_html_start[]    asm("_binary_index_html_start");
+extern const uint8_t index_html_end[]      asm("_binary_index_html_end");
+extern const uint8_t index_html_gz_start[] asm("_binary_index_html_gz_start");
+extern const uint8_t index_html_gz_end[]   asm("_binary_index_html_gz_end");
+extern const uint8_t app_css_start[]       asm("_binary_app_css_start");
+extern const uint8_t app_css_end[]         asm("_binary_app_css_end");
+extern const uint8_t app_css_gz_start[]    asm("_binary_app_css_gz_start");
+extern const uint8_t app_css_gz_end[]      asm("_binary_app_css_gz_end");
+extern const uint8_t app_js_start[]        asm("_binary_app_js_start");
+extern const uint8_t app_js_end[]          asm("_binary_app_js_end");
+extern const uint8_t app_js_gz_start[]     asm("_binary_app_js_gz_start");
+extern const uint8_t app_js_gz_end[]       asm("_binary_app_js_gz_end");
+
+#define WEB_ASSET_BLOB(sym) { sym##_start, (size_t)(sym##_end - sym##_start) }
+
+/**
+ * @brief 建立嵌入资源表（仅记录链接符号的地址与长度）
+ */
+static esp_err_t web_module_load_assets(void)
+{
+    const web_asset_blob_t blobs[WEB_ASSET_COUNT][2] = {
+        [WEB_ASSET_INDEX_HTML] = { WEB_ASSET_BLOB(index_html), WEB_ASSET_BLOB(index_html_gz) },
+        [WEB_ASSET_APP_CSS]    = { WEB_ASSET_BLOB(app_css),    WEB_ASSET_BLOB(app_css_gz)    },
+        [WEB_ASSET_APP_JS]     = { WEB_ASSET_BLOB(app_js),     WEB_ASSET_BLOB(app_js_gz)     },
+    };
+
+    memcpy(s_web_asset_blobs, blobs, sizeof(s_web_asset_blobs));
+    return ESP_OK;
+}
+#endif
+
+#if CONFIG_XN_WEB_WIFI_ASSETS_PARTITION
+/* -------------------- 分区内存映射资源 -------------------- */
+
+/*
+ * 资源包格式（由 tools/gen_web_assets.py --pack 生成，小端）：
+ *   header : magic(u32) version(u16) count(u16)
+ *   entry  : name[24]（'\0' 填充） offset(u32，相对镜像起始) length(u32)，共 count 项
+ *   data   : 各资源数据，按 4 字节对齐
+ * gzip 版本以 "<name>.gz" 作为独立条目存放。
+ */
+#define WEB_PACK_MAGIC       0x41574E58u /* "XNWA" */
+#define WEB_PACK_VERSION     1
+#define WEB_PACK_HEADER_SIZE 8
+#define WEB_PACK_NAME_LEN    24
+#define WEB_PACK_ENTRY_SIZE  (WEB_PACK_NAME_LEN + 8)
+
+/* 映射句柄：映射后常驻，不再解除 */
+static esp_partition_mmap_handle_t s_web_pack_handle;
+
+static uint32_t web_pack_read_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief 映射 wifi_spiffs 分区并建立资源偏移 / 长度表
+ *
+ * 仅在初始化时执行一次，之后请求处理直接使用映射地址，不再访问 Flash 驱动。
+ */
+static esp_err_t web_module_load_assets(void)
+{
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_ANY,
+                                                           "wifi_spiffs");
+    if (part == NULL) {
+        ESP_LOGE(TAG, "asset partition wifi_spiffs not found");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    const void *map = NULL;
+    esp_err_t   ret = esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA,
+                                         &map, &s_web_pack_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "asset partition mmap failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    const uint8_t *base    = (const uint8_t *)map;
+    uint16_t       version = (uint16_t)(base[4] | (base[5] << 8));
+    uint16_t       count   = (uint16_t)(base[6] | (base[7] << 8));
+
+    if (web_pack_read_u32(base) != WEB_PACK_MAGIC || version != WEB_PACK_VERSION ||
+        WEB_PACK_HEADER_SIZE + (size_t)count * WEB_PACK_ENTRY_SIZE > part->size) {
+        ESP_LOGE(TAG, "invalid asset pack in wifi_spiffs (magic/version mismatch)");
+        esp_partition_munmap(s_web_pack_handle);
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    for (uint16_t i = 0; i < count; i++) {
+        const uint8_t *entry  = base + WEB_PACK_HEADER_SIZE + (size_t)i * WEB_PACK_ENTRY_SIZE;
+        uint32_t       offset = web_pack_read_u32(entry + WEB_PACK_NAME_LEN);
+        uint32_t       length = web_pack_read_u32(entry + WEB_PACK_NAME_LEN + 4);
+        char           name[WEB_PACK_NAME_LEN + 1] = {0};
+
+        memcpy(name, entry, WEB_PACK_NAME_LEN);
+
+        if ((uint64_t)offset + length > part->size) {
+            ESP_LOGE(TAG, "asset %s out of partition range", name);
+            continue;
+        }
+
+        /* 名称以 ".gz" 结尾的条目为对应资源的 gzip 版本 */
+        size_t name_len = strlen(name);
+        int    variant  = 0;
+        if (name_len > 3 && strcmp(name + name_len - 3, ".gz") == 0) {
+            name[name_len - 3] = '\0';
+            variant            = 1;
+        }
+
+        for (int id = 0; id < WEB_ASSET_COUNT; id++) {
+            if (strcmp(name, s_web_asset_files[id].name) == 0) {
+                s_web_asset_blobs[id][variant].data = base + offset;
+                s_web_asset_blobs[id][variant].len  = length;
+                break;
+            }
+        }
+    }
+
+    for (int id = 0; id < WEB_ASSET_COUNT; id++) {
+        if (s_web_asset_blobs[id][0].data == NULL) {
+            ESP_LOGE(TAG, "asset %s missing in pack", s_web_asset_files[id].name);
+            esp_partition_munmap(s_web_pack_handle);
+            memset(s_web_asset_blobs, 0, sizeof(s_web_asset_blobs));
+            return ESP_ERR_NOT_FOUND;
+        }
+    }
+
+    ESP_LOGI(TAG, "asset pack mapped: %u entries", (unsigned)count);
+    return ESP_OK;
+}
+#endif
+
+#if CONFIG_XN_WEB_WIFI_ASSETS_SPIFFS
 /* -------------------- SPIFFS 挂载辅助 -------------------- */
 
 /**
@@ -95,7 +360,7 @@ static void web_url_decode_inplace(char *str)
  * - base_path:  "/spiffs"（HTTP 处理函数按此路径访问文件）
  * - max_files:  4（当前仅三个静态文件，预留 1 个）
  */
-static esp_err_t web_module_mount_spiffs(void)
+static esp_err_t web_module_load_assets(void)
 {
     esp_vfs_spiffs_conf_t conf = {
         .base_path              = "/spiffs",
@@ -117,32 +382,291 @@ static esp_err_t web_module_mount_spiffs(void)
 
     return ret;
 }
+#endif
 
 /* -------------------- 静态文件响应辅助 -------------------- */
 
 /**
- * @brief 以分块响应的方式发送一个静态文件
+ * @brief 跳过 HTTP 头部中的可选空白（OWS：空格 / 制表符）
+ */
+static const char *web_skip_ows(const char *p)
+{
+    while (*p == ' ' || *p == '\t') {
+        p++;
+    }
+    return p;
+}
+
+/**
+ * @brief 判断客户端是否接受 gzip 编码
  *
- * @param req          HTTP 请求对象
- * @param file_path    文件在 SPIFFS 上的完整路径（如 "/spiffs/index.html"）
- * @param content_type Content-Type 头部值
+ * 在 Accept-Encoding 中查找 "gzip" 记号，显式声明 q=0（如 "gzip;q=0"、"gzip; Q = 0.000"）时视为不接受。
+ * ";" 与 "=" 两侧允许空白，参数名 q 不区分大小写（RFC 9110）。
  */
-static esp_err_t web_module_serve_file(httpd_req_t *req,
-                                       const char  *file_path,
-                                       const char  *content_type)
+static bool web_module_accepts_gzip(httpd_req_t *req)
 {
-    FILE *f = fopen(file_path, "r");
+    char accept[96] = {0};
+
+    if (httpd_req_get_hdr_value_len(req, "Accept-Encoding") == 0) {
+        return false;
+    }
+    /* 头部过长时会被截断，但截断部分仍可用于查找 gzip 记号 */
+    (void)httpd_req_get_hdr_value_str(req, "Accept-Encoding", accept, sizeof(accept));
+
+    const char *p = strstr(accept, "gzip");
+    if (p == NULL) {
+        return false;
+    }
+
+    p = web_skip_ows(p + strlen("gzip"));
+    if (*p != ';') {
+        return true;
+    }
+    p = web_skip_ows(p + 1);
+    if (*p != 'q' && *p != 'Q') {
+        return true;
+    }
+    p = web_skip_ows(p + 1);
+    if (*p != '=') {
+        return true;
+    }
+    p = web_skip_ows(p + 1);
+
+    /* "q=0" / "q=0.0" 表示拒绝，"q=0.5"、"q=1" 等仍表示接受 */
+    if (*p != '0') {
+        return true;
+    }
+    p++;
+    if (*p == '.') {
+        p++;
+    }
+    while (*p == '0') {
+        p++;
+    }
+    return (*p >= '1' && *p <= '9');
+}
+
+/**
+ * @brief 判断请求 URL 是否带有与当前内容一致的指纹（?v=<hash>）
+ */
+static bool web_module_is_fingerprinted(httpd_req_t *req, const web_asset_file_t *asset)
+{
+    char query[48]   = {0};
+    char version[24] = {0};
+
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK) {
+        return false;
+    }
+    if (httpd_query_key_value(query, "v", version, sizeof(version)) != ESP_OK) {
+        return false;
+    }
+
+    return strcmp(version, asset->hash) == 0;
+}
+
+/* -------------------- 静态资源发送统计 -------------------- */
+
+/*
+ * 每个资源、每种编码累计发送次数、字节数、耗时与 httpd 任务 CPU 时间，经 /api/metrics 导出，
+ * 供 tools/bench_web_assets.py 对比不同资源模式的吞吐与单次页面加载的 CPU 开销。
+ * 发送与导出都在 httpd 任务中执行，无需加锁。
+ */
+#if CONFIG_XN_WEB_WIFI_ASSETS_EMBED
+#define WEB_ASSET_MODE_NAME "embed"
+#elif CONFIG_XN_WEB_WIFI_ASSETS_PARTITION
+#define WEB_ASSET_MODE_NAME "partition"
+#else
+#define WEB_ASSET_MODE_NAME "spiffs"
+#endif
+
+/* CPU 时间取自 FreeRTOS 运行时统计，计数器以 esp_timer（微秒）为时钟时才能直接换算 */
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS && CONFIG_FREERTOS_RUN_TIME_STATS_USING_ESP_TIMER
+#define WEB_ASSET_CPU_STATS 1
+#else
+#define WEB_ASSET_CPU_STATS 0
+#endif
+
+typedef struct {
+    uint32_t responses; ///< 带内容的响应次数（不含 304）
+    uint64_t bytes;     ///< 发送的资源字节数（不含 HTTP 头）
+    uint64_t wall_us;   ///< 处理函数内的发送耗时
+    uint64_t cpu_us;    ///< 其中 httpd 任务实际占用的 CPU 时间（阻塞等待 socket 不计入）
+} web_asset_stats_t;
+
+/* 下标 [资源][0: 原始, 1: gzip] */
+static web_asset_stats_t s_web_asset_stats[WEB_ASSET_COUNT][2];
+
+/**
+ * @brief 当前任务累计运行时间（微秒）；未启用运行时统计时返回 0
+ */
+static uint32_t web_module_task_cpu_us(void)
+{
+#if WEB_ASSET_CPU_STATS
+    TaskStatus_t status;
+    vTaskGetInfo(NULL, &status, pdFALSE, eRunning);
+    return status.ulRunTimeCounter;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief 以 Prometheus 文本格式输出静态资源发送统计
+ */
+static esp_err_t web_module_asset_stats_write(web_text_write_fn_t write, void *ctx)
+{
+    static const char *const encodings[2] = { "identity", "gzip" };
+    static const struct {
+        const char *name;
+        const char *help;
+        const char *type;
+    } series[] = {
+        { "web_asset_responses_total",    "Static asset responses with body.",                "counter" },
+        { "web_asset_bytes_total",        "Static asset body bytes sent.",                    "counter" },
+        { "web_asset_send_seconds_total", "Wall time spent sending static assets.",           "counter" },
+        { "web_asset_cpu_seconds_total",  "httpd task CPU time spent sending static assets.", "counter" },
+    };
+    char      line[160];
+    int       n;
+    esp_err_t ret;
+
+    n = snprintf(line, sizeof(line),
+                 "# HELP web_asset_info Static asset source.\n"
+                 "# TYPE web_asset_info gauge\n"
+                 "web_asset_info{mode=\"%s\",cpu_stats=\"%d\"} 1\n",
+                 WEB_ASSET_MODE_NAME, WEB_ASSET_CPU_STATS);
+    ret = write(ctx, line, (size_t)n);
+
+    for (size_t k = 0; k < sizeof(series) / sizeof(series[0]) && ret == ESP_OK; k++) {
+        n   = snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s %s\n",
+                       series[k].name, series[k].help, series[k].name, series[k].type);
+        ret = write(ctx, line, (size_t)n);
+
+        for (int id = 0; id < WEB_ASSET_COUNT && ret == ESP_OK; id++) {
+            for (int gz = 0; gz < 2 && ret == ESP_OK; gz++) {
+                const web_asset_stats_t *st = &s_web_asset_stats[id][gz];
+                uint64_t                 us = (k == 2) ? st->wall_us : st->cpu_us;
+
+                n = snprintf(line, sizeof(line), "%s{asset=\"%s\",encoding=\"%s\"} ",
+                             series[k].name, s_web_asset_files[id].name, encodings[gz]);
+                if (k == 0) {
+                    n += snprintf(line + n, sizeof(line) - n, "%lu\n", (unsigned long)st->responses);
+                } else if (k == 1) {
+                    n += snprintf(line + n, sizeof(line) - n, "%llu\n", (unsigned long long)st->bytes);
+                } else {
+                    n += snprintf(line + n, sizeof(line) - n, "%llu.%06llu\n",
+                                  (unsigned long long)(us / 1000000), (unsigned long long)(us % 1000000));
+                }
+                ret = write(ctx, line, (size_t)n);
+            }
+        }
+    }
+    return ret;
+}
+
+/**
+ * @brief 判断 If-None-Match 是否命中当前资源
+ *
+ * 原始与 gzip 版本的 ETag 分别为 "<hash>" 与 "<hash>-gz"，两者内容一致，
+ * 因此只要请求头中包含 hash（或为 "*"）即视为命中。
+ */
+static bool web_module_etag_matches(httpd_req_t *req, const web_asset_file_t *asset)
+{
+    char if_none_match[96] = {0};
+
+    if (httpd_req_get_hdr_value_len(req, "If-None-Match") == 0) {
+        return false;
+    }
+    (void)httpd_req_get_hdr_value_str(req, "If-None-Match", if_none_match, sizeof(if_none_match));
+
+    return strstr(if_none_match, asset->hash) != NULL || strchr(if_none_match, '*') != NULL;
+}
+
+/**
+ * @brief 发送一个静态资源
+ *
+ * - 先确定实际发送的版本：客户端接受 gzip 且存在预压缩版本时发送 gzip 版本（附带
+ *   Content-Encoding: gzip），否则发送原始版本；ETag 由该版本生成，304 响应同样如此；
+ * - 带 ETag 验证：If-None-Match 命中时直接返回 304，不读取资源内容；
+ * - 缓存策略：CSS/JS 通过带指纹 URL 访问时允许长期缓存，其余情况 no-cache（每次重新验证）；
+ * - 嵌入固件 / 分区映射模式：直接把 Flash 映射区的整段数据交给 httpd_resp_send，
+ *   由发送路径按 socket 能力分段写出，无文件系统访问与中间拷贝；
+ * - SPIFFS 模式：先打开文件（.gz 缺失时回退到原始文件），再以分块响应的方式发送。
+ *
+ * 每次成功发送计入 s_web_asset_stats（字节数、耗时、httpd 任务 CPU 时间），经 /api/metrics 导出。
+ *
+ * @param req   HTTP 请求对象
+ * @param id    要发送的静态资源
+ */
+static esp_err_t web_module_serve_file(httpd_req_t *req, web_asset_id_t id)
+{
+    const web_asset_file_t *asset     = &s_web_asset_files[id];
+    bool                    use_gzip  = false;
+    int64_t                 t_start   = esp_timer_get_time();
+    uint32_t                cpu_start = web_module_task_cpu_us();
+    size_t                  sent      = 0;
+    esp_err_t               ret       = ESP_OK;
+
+    /* 1. 确定实际发送的版本 */
+#if CONFIG_XN_WEB_WIFI_ASSETS_EMBED || CONFIG_XN_WEB_WIFI_ASSETS_PARTITION
+    const web_asset_blob_t *blob = &s_web_asset_blobs[id][0];
+
+    if (s_web_asset_blobs[id][1].data != NULL && web_module_accepts_gzip(req)) {
+        blob     = &s_web_asset_blobs[id][1];
+        use_gzip = true;
+    }
+#else
+    char  path[48];
+    FILE *f = NULL;
+
+    if (web_module_accepts_gzip(req)) {
+        snprintf(path, sizeof(path), "/spiffs/%s.gz", asset->name);
+        f        = fopen(path, "r");
+        use_gzip = (f != NULL);
+    }
+    if (f == NULL) {
+        snprintf(path, sizeof(path), "/spiffs/%s", asset->name);
+        f = fopen(path, "r");
+    }
     if (f == NULL) {
-        ESP_LOGE(TAG, "open file failed: %s", file_path);
+        ESP_LOGE(TAG, "open file failed: %s", path);
         httpd_resp_send_err(req,
                             HTTPD_500_INTERNAL_SERVER_ERROR,
                             "open file failed");
         return ESP_FAIL;
     }
+#endif
+
+    /* 2. 缓存相关头部与 ETag 验证（ETag 字符串需在响应发送前保持有效，放在本函数栈上即可） */
+    char etag[24];
+    snprintf(etag, sizeof(etag), use_gzip ? "\"%s-gz\"" : "\"%s\"", asset->hash);
+
+    bool immutable = asset->immutable && web_module_is_fingerprinted(req, asset);
+
+    httpd_resp_set_hdr(req, "ETag", etag);
+    httpd_resp_set_hdr(req, "Cache-Control", immutable ? WEB_CACHE_IMMUTABLE : "no-cache");
+    /* 同一 URL 的响应随 Accept-Encoding 变化，告知中间缓存 */
+    httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+
+    if (web_module_etag_matches(req, asset)) {
+        /* 浏览器缓存仍然有效：仅返回 304，不读取资源内容 */
+#if !(CONFIG_XN_WEB_WIFI_ASSETS_EMBED || CONFIG_XN_WEB_WIFI_ASSETS_PARTITION)
+        fclose(f);
+#endif
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
 
-    httpd_resp_set_type(req, content_type);
-    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    /* 3. 发送内容 */
+    httpd_resp_set_type(req, asset->content_type);
+    if (use_gzip) {
+        httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    }
 
+#if CONFIG_XN_WEB_WIFI_ASSETS_EMBED || CONFIG_XN_WEB_WIFI_ASSETS_PARTITION
+    ret  = httpd_resp_send(req, (const char *)blob->data, (ssize_t)blob->len);
+    sent = blob->len;
+#else
     char  buf[512];
     size_t n;
     while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
@@ -151,265 +675,430 @@ static esp_err_t web_module_serve_file(httpd_req_t *req,
             httpd_resp_sendstr_chunk(req, NULL); /* 结束分块 */
             return ESP_FAIL;
         }
+        sent += n;
     }
 
     fclose(f);
-    httpd_resp_send_chunk(req, NULL, 0); /* 告知响应结束 */
-    return ESP_OK;
+    ret = httpd_resp_send_chunk(req, NULL, 0); /* 告知响应结束 */
+#endif
+
+    if (ret == ESP_OK) {
+        web_asset_stats_t *st = &s_web_asset_stats[id][use_gzip ? 1 : 0];
+
+        st->responses++;
+        st->bytes   += sent;
+        st->wall_us += (uint64_t)(esp_timer_get_time() - t_start);
+        st->cpu_us  += (uint32_t)(web_module_task_cpu_us() - cpu_start); /* 计数器回绕时差值仍正确 */
+    }
+
+    return ret;
 }
 
 /* -------------------- 具体 URI 处理函数 -------------------- */
 
 /**
- * @brief 根路径与 /index.html：返回主页面
+ * @brief 静态资源：index.html / app.css / app.js
+ *
+ * 注册时通过 user_ctx 绑定对应的 web_asset_route_t。
  */
-static esp_err_t web_module_root_get_handler(httpd_req_t *req)
+static esp_err_t web_module_static_get_handler(httpd_req_t *req)
 {
-    return web_module_serve_file(req, "/spiffs/index.html", "text/html");
+    const web_asset_route_t *route = (const web_asset_route_t *)req->user_ctx;
+    return web_module_serve_file(req, route->id);
 }
 
 /**
- * @brief app.css：页面样式
+ * @brief 查询当前 WiFi 状态（未配置回调时填充占位值）
  */
-static esp_err_t web_module_css_get_handler(httpd_req_t *req)
+static esp_err_t web_module_query_status(web_wifi_status_t *status)
 {
-    return web_module_serve_file(req, "/spiffs/app.css", "text/css");
+    memset(status, 0, sizeof(*status));
+
+    if (s_web_cfg.get_status_cb) {
+        return s_web_cfg.get_status_cb(status);
+    }
+
+    /* 未提供回调时给出一个简单占位值 */
+    status->connected = false;
+    status->state     = WEB_WIFI_STATUS_STATE_IDLE;
+    strncpy(status->ssid, "-", sizeof(status->ssid));
+    strncpy(status->ip, "-", sizeof(status->ip));
+    strncpy(status->mode, "-", sizeof(status->mode));
+    return ESP_OK;
 }
 
 /**
- * @brief app.js：前端脚本
+ * @brief 将 WiFi 状态写为 JSON 对象
+ *
+ * 形如 {"connected":true,"state":2,"ssid":"xxx","ip":"x.x.x.x","rssi":-60,"mode":"AP+STA"}，
+ * /api/wifi/status 与 SSE 推送共用。
  */
-static esp_err_t web_module_js_get_handler(httpd_req_t *req)
+static void web_module_write_status(web_json_writer_t *w, const web_wifi_status_t *status)
 {
-    return web_module_serve_file(req, "/spiffs/app.js", "application/javascript");
+    web_json_obj_begin(w, NULL);
+    web_json_bool(w, "connected", status->connected);
+    web_json_int(w, "state", (int32_t)status->state);
+    web_json_str(w, "ssid", status->ssid);
+    web_json_str(w, "ip", status->ip);
+    web_json_int(w, "rssi", status->rssi);
+    web_json_str(w, "mode", status->mode);
+    web_json_obj_end(w);
 }
 
 /**
  * @brief /api/wifi/status：查询当前 WiFi 状态（可选）
- *
- * 若未配置回调，返回简单的占位结果，方便前端调试。
  */
 static esp_err_t web_module_status_get_handler(httpd_req_t *req)
 {
-    web_wifi_status_t status = {0};
-    char              json[192];
-
-    if (s_web_cfg.get_status_cb) {
-        if (s_web_cfg.get_status_cb(&status) != ESP_OK) {
-            httpd_resp_send_err(req,
-                                HTTPD_500_INTERNAL_SERVER_ERROR,
-                                "status query failed");
-            return ESP_OK;
-        }
-    } else {
-        /* 未提供回调时给出一个简单占位值 */
-        status.connected = false;
-        status.state     = WEB_WIFI_STATUS_STATE_IDLE;
-        strncpy(status.ssid, "-", sizeof(status.ssid));
-        status.ssid[sizeof(status.ssid) - 1] = '\0';
-        strncpy(status.ip, "-", sizeof(status.ip));
-        status.ip[sizeof(status.ip) - 1] = '\0';
-        status.rssi = 0;
-        strncpy(status.mode, "-", sizeof(status.mode));
-        status.mode[sizeof(status.mode) - 1] = '\0';
-    }
-
-    /* 简单 JSON 序列化：假定 SSID/IP/mode 不包含引号等特殊字符 */
-    int len = snprintf(json,
-                       sizeof(json),
-                       "{\"connected\":%s,\"state\":%d,\"ssid\":\"%s\",\"ip\":\"%s\",\"rssi\":%d,\"mode\":\"%s\"}",
-                       status.connected ? "true" : "false",
-                       (int)status.state,
-                       status.ssid,
-                       status.ip,
-                       (int)status.rssi,
-                       status.mode);
+    web_wifi_status_t status;
 
-    if (len < 0) {
+    if (web_module_query_status(&status) != ESP_OK) {
         httpd_resp_send_err(req,
                             HTTPD_500_INTERNAL_SERVER_ERROR,
-                            "format json failed");
+                            "status query failed");
         return ESP_OK;
     }
-    if (len >= (int)sizeof(json)) {
-        len = (int)sizeof(json) - 1;
-    }
 
     httpd_resp_set_type(req, "application/json");
     httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
-    httpd_resp_send(req, json, len);
-    return ESP_OK;
+
+    web_json_writer_t w;
+    web_json_init_resp(&w, req);
+    web_module_write_status(&w, &status);
+    return web_json_finish(&w);
 }
 
+/* -------------------- 状态推送（Server-Sent Events） -------------------- */
+
+/*
+ * /api/wifi/events 以 SSE 方式推送状态：
+ * - 处理函数只写出响应头与首帧，随后返回，socket 保持打开并记录在 s_web_event_fds 中；
+ * - 状态变化时由 web_module_notify_status() 通过 httpd_queue_work 切换到 httpd 任务，
+ *   在 httpd 任务内向所有订阅 socket 写出一帧 "data: {...}\n\n"；
+ * - socket 关闭时由 close_fn 回调移除记录。
+ *
+ * s_web_event_fds 只在 httpd 任务中读写，无需加锁。
+ */
+#define WEB_EVENTS_MAX_CLIENTS 4
+
+static int           s_web_event_fds[WEB_EVENTS_MAX_CLIENTS] = { -1, -1, -1, -1 };
+static uint32_t      s_web_event_seq[WEB_EVENTS_MAX_CLIENTS];  /* 订阅先后顺序，满员时淘汰最早的 */
+static uint32_t      s_web_event_next_seq = 0;
+static volatile int  s_web_event_clients  = 0;                 /* 当前订阅数，供其它任务快速判断 */
+static volatile bool s_web_event_pending  = false;             /* 已排队但尚未发送的推送 */
+
+/* 单帧 SSE 缓冲大小：按 SSID 全部需要 \uXXXX 转义的最坏情况估算 */
+#define WEB_EVENT_FRAME_SIZE 320
+
 /**
- * @brief /api/wifi/saved：获取已保存 WiFi 列表
+ * @brief 生成一帧 SSE 状态数据："data: {...}\n\n"
+ *
+ * @return 帧长度；失败返回 -1
  */
-static esp_err_t web_module_saved_get_handler(httpd_req_t *req)
+static int web_module_format_status_event(char *buf, size_t size)
 {
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    static const char PREFIX[] = "data: ";
+    const size_t      prefix_len = sizeof(PREFIX) - 1;
 
-    /* 未提供回调时返回空列表，方便前端统一处理 */
-    if (s_web_cfg.get_saved_list_cb == NULL) {
-        static const char *EMPTY_JSON = "{\"items\":[]}";
-        httpd_resp_send(req, EMPTY_JSON, strlen(EMPTY_JSON));
-        return ESP_OK;
+    if (size < prefix_len + 3) {
+        return -1;
     }
 
-    /* 第一次调用仅查询需要的条目数量，避免多余的堆分配 */
-    size_t    cnt = 0;
-    esp_err_t ret = s_web_cfg.get_saved_list_cb(NULL, &cnt);
-    if (ret != ESP_OK) {
-        httpd_resp_send_err(req,
-                            HTTPD_500_INTERNAL_SERVER_ERROR,
-                            "load saved wifi failed");
-        return ESP_OK;
+    web_wifi_status_t status;
+    if (web_module_query_status(&status) != ESP_OK) {
+        return -1;
     }
 
-    if (cnt == 0) {
-        static const char *EMPTY_JSON = "{\"items\":[]}";
-        httpd_resp_send(req, EMPTY_JSON, strlen(EMPTY_JSON));
-        return ESP_OK;
+    /* JSON 写在前缀之后，末尾预留两个换行（写入器结尾的 '\0' 会被换行覆盖） */
+    web_json_writer_t w;
+    memcpy(buf, PREFIX, prefix_len);
+    web_json_init_buf(&w, buf + prefix_len, size - prefix_len - 2);
+    web_module_write_status(&w, &status);
+    if (web_json_finish(&w) != ESP_OK) {
+        return -1;
     }
 
-    web_saved_wifi_info_t *list = (web_saved_wifi_info_t *)malloc(cnt * sizeof(web_saved_wifi_info_t));
-    if (list == NULL) {
-        httpd_resp_send_err(req,
-                            HTTPD_500_INTERNAL_SERVER_ERROR,
-                            "no memory");
-        return ESP_OK;
+    int len = (int)(prefix_len + w.total);
+    buf[len++] = '\n';
+    buf[len++] = '\n';
+    return len;
+}
+
+/**
+ * @brief 从订阅表中移除指定 socket（不关闭 socket）
+ */
+static void web_module_events_remove_fd(int sockfd)
+{
+    for (int i = 0; i < WEB_EVENTS_MAX_CLIENTS; i++) {
+        if (s_web_event_fds[i] == sockfd) {
+            s_web_event_fds[i] = -1;
+            s_web_event_clients--;
+        }
     }
+}
 
-    size_t cap = cnt;
-    ret        = s_web_cfg.get_saved_list_cb(list, &cap);
-    if (ret != ESP_OK) {
-        free(list);
-        httpd_resp_send_err(req,
-                            HTTPD_500_INTERNAL_SERVER_ERROR,
-                            "load saved wifi failed");
-        return ESP_OK;
+/**
+ * @brief httpd 任务中执行的推送工作：向全部订阅者写出一帧当前状态
+ */
+static void web_module_events_push_work(void *arg)
+{
+    (void)arg;
+
+    s_web_event_pending = false;
+
+    if (s_web_event_clients <= 0) {
+        return;
+    }
+
+    char frame[WEB_EVENT_FRAME_SIZE];
+    int  len = web_module_format_status_event(frame, sizeof(frame));
+    if (len < 0) {
+        return;
     }
 
-    if (cap > cnt) {
-        cap = cnt;
+    for (int i = 0; i < WEB_EVENTS_MAX_CLIENTS; i++) {
+        int fd = s_web_event_fds[i];
+        if (fd < 0) {
+            continue;
+        }
+        if (httpd_socket_send(s_http_server, fd, frame, (size_t)len, 0) < 0) {
+            /* 写失败说明客户端已离开，触发关闭（close_fn 中会移除记录） */
+            ESP_LOGD(TAG, "event client fd=%d gone", fd);
+            httpd_sess_trigger_close(s_http_server, fd);
+        }
     }
+}
 
-    /* 序列化为形如 {"items":[{"index":0,"ssid":"xxx"}, ...]} 的 JSON */
-    char  json[512];
-    size_t offset = 0;
+/**
+ * @brief socket 关闭回调：清理订阅记录后关闭 socket
+ *
+ * 设置 close_fn 后 httpd 不再自行关闭 socket，因此这里需要调用 close()。
+ */
+static void web_module_on_sock_close(httpd_handle_t hd, int sockfd)
+{
+    (void)hd;
+    web_module_events_remove_fd(sockfd);
+    close(sockfd);
+}
 
-    offset += (size_t)snprintf(json + offset, sizeof(json) - offset, "{\"items\":[");
+/**
+ * @brief /api/wifi/events：订阅状态推送（SSE）
+ *
+ * 响应头与首帧直接写到 socket，处理函数返回后连接保持打开。
+ * 订阅数已满时淘汰最早的订阅（通常是已离开但尚未被发现的客户端）。
+ */
+static esp_err_t web_module_events_get_handler(httpd_req_t *req)
+{
+    static const char HEADERS[] =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/event-stream\r\n"
+        "Cache-Control: no-cache\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n"
+        "retry: 3000\n\n";
+
+    int sockfd = httpd_req_to_sockfd(req);
+    int slot   = -1;
+
+    for (int i = 0; i < WEB_EVENTS_MAX_CLIENTS; i++) {
+        if (s_web_event_fds[i] == sockfd) {
+            slot = i;   /* 同一连接重复订阅，沿用原位置 */
+            break;
+        }
+        if (slot < 0 && s_web_event_fds[i] < 0) {
+            slot = i;
+        }
+    }
 
-    for (size_t i = 0; i < cap && offset < sizeof(json); i++) {
-        const char *comma = (i == 0) ? "" : ",";
-        offset += (size_t)snprintf(json + offset,
-                                   sizeof(json) - offset,
-                                   "%s{\"index\":%u,\"ssid\":\"%s\"}",
-                                   comma,
-                                   (unsigned)i,
-                                   list[i].ssid);
+    if (slot < 0) {
+        slot = 0;
+        for (int i = 1; i < WEB_EVENTS_MAX_CLIENTS; i++) {
+            if (s_web_event_seq[i] < s_web_event_seq[slot]) {
+                slot = i;
+            }
+        }
+        int old_fd = s_web_event_fds[slot];
+        web_module_events_remove_fd(old_fd);
+        httpd_sess_trigger_close(s_http_server, old_fd);
     }
 
-    free(list);
+    char frame[WEB_EVENT_FRAME_SIZE];
+    int  len = web_module_format_status_event(frame, sizeof(frame));
 
-    if (offset >= sizeof(json)) {
-        /* 理论上不会超出，若超出则截断为一个空列表作为兜底 */
-        const char *FALLBACK = "{\"items\":[]}";
-        httpd_resp_send(req, FALLBACK, strlen(FALLBACK));
-        return ESP_OK;
+    if (httpd_send(req, HEADERS, sizeof(HEADERS) - 1) < 0 ||
+        (len > 0 && httpd_send(req, frame, (size_t)len) < 0)) {
+        return ESP_FAIL;
     }
 
-    offset += (size_t)snprintf(json + offset, sizeof(json) - offset, "]}");
+    if (s_web_event_fds[slot] != sockfd) {
+        s_web_event_fds[slot] = sockfd;
+        s_web_event_clients++;
+    }
+    s_web_event_seq[slot] = ++s_web_event_next_seq;
 
-    httpd_resp_send(req, json, (int)offset);
+    ESP_LOGD(TAG, "event client fd=%d subscribed (slot %d)", sockfd, slot);
     return ESP_OK;
 }
 
+typedef struct {
+    web_json_writer_t w;
+    uint32_t          index;
+} web_saved_list_ctx_t;
+
 /**
- * @brief /api/wifi/scan：扫描附近 WiFi 列表
+ * @brief 将一条已保存 WiFi 写入 JSON 数组
  */
-static esp_err_t web_module_scan_get_handler(httpd_req_t *req)
+static esp_err_t web_module_saved_visit(void *ctx, const web_saved_wifi_info_t *info)
+{
+    web_saved_list_ctx_t *sc = (web_saved_list_ctx_t *)ctx;
+    web_json_writer_t    *w  = &sc->w;
+
+    web_json_obj_begin(w, NULL);
+    web_json_uint(w, "index", sc->index++);
+    web_json_str(w, "ssid", info->ssid);
+    web_json_uint(w, "success", info->success_count);
+    web_json_uint(w, "fail", info->fail_count);
+    web_json_uint(w, "last_success", info->last_success);
+    web_json_uint(w, "ip_ms", info->time_to_ip_ms);
+    web_json_obj_end(w);
+
+    return w->err;
+}
+
+/**
+ * @brief /api/wifi/saved：获取已保存 WiFi 列表
+ *
+ * 遍历回调逐条交出网络，直接流式序列化为形如
+ * {"items":[{"index":0,"ssid":"xxx","success":N,"fail":N,"last_success":T,"ip_ms":N}, ...]} 的 JSON，
+ * 只遍历一次，不分配中间数组。
+ */
+static esp_err_t web_module_saved_get_handler(httpd_req_t *req)
 {
     httpd_resp_set_type(req, "application/json");
     httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
 
-    /* 未提供回调时返回空列表，方便前端统一处理 */
-    if (s_web_cfg.scan_cb == NULL) {
-        static const char *EMPTY_JSON = "{\"items\":[]}";
-        httpd_resp_send(req, EMPTY_JSON, strlen(EMPTY_JSON));
-        return ESP_OK;
+    web_saved_list_ctx_t sc = { .index = 0 };
+    web_json_init_resp(&sc.w, req);
+    web_json_obj_begin(&sc.w, NULL);
+    web_json_arr_begin(&sc.w, "items");
+
+    esp_err_t ret = s_web_cfg.foreach_saved_cb(web_module_saved_visit, &sc);
+    if (ret != ESP_OK) {
+        /* 头部可能已发出，无法再返回错误页，直接结束本次连接 */
+        return ESP_FAIL;
     }
 
-    /* 使用堆缓冲区承载扫描结果，具体数量由回调实现控制 */
-    enum { WEB_MAX_SCAN_RESULT = 32 };
-    web_scan_result_t *list = (web_scan_result_t *)malloc(WEB_MAX_SCAN_RESULT * sizeof(web_scan_result_t));
-    if (list == NULL) {
-        httpd_resp_send_err(req,
-                            HTTPD_500_INTERNAL_SERVER_ERROR,
-                            "no memory");
-        return ESP_OK;
+    web_json_arr_end(&sc.w);
+    web_json_obj_end(&sc.w);
+    return web_json_finish(&sc.w);
+}
+
+/**
+ * @brief /api/wifi/scan[?max_age=ms]：发起一次异步扫描
+ *
+ * 立即返回 {"job":N}，前端随后轮询 /api/wifi/scan/result?job=N 获取结果，
+ * 扫描期间不占用 HTTP 服务器任务。max_age 指定可接受的缓存结果年龄，
+ * 缺省时由上层按默认缓存策略决定。
+ */
+static esp_err_t web_module_scan_get_handler(httpd_req_t *req)
+{
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+
+    uint32_t max_age_ms  = WEB_SCAN_MAX_AGE_DEFAULT;
+    char     query[32]   = {0};
+    char     max_age[12] = {0};
+
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "max_age", max_age, sizeof(max_age)) == ESP_OK) {
+        max_age_ms = (uint32_t)strtoul(max_age, NULL, 10);
     }
 
-    size_t    cnt = WEB_MAX_SCAN_RESULT;
-    esp_err_t ret = s_web_cfg.scan_cb(list, &cnt);
+    uint32_t  job_id = 0;
+    esp_err_t ret    = s_web_cfg.scan_start_cb(max_age_ms, &job_id);
     if (ret != ESP_OK) {
         httpd_resp_send_err(req,
                             HTTPD_500_INTERNAL_SERVER_ERROR,
-                            "scan failed");
-        free(list);
+                            "scan start failed");
         return ESP_OK;
     }
 
-    if (cnt == 0) {
-        static const char *EMPTY_JSON = "{\"items\":[]}";
-        httpd_resp_send(req, EMPTY_JSON, strlen(EMPTY_JSON));
-        free(list);
+    web_json_writer_t w;
+    web_json_init_resp(&w, req);
+    web_json_obj_begin(&w, NULL);
+    web_json_uint(&w, "job", job_id);
+    web_json_obj_end(&w);
+    return web_json_finish(&w);
+}
+
+/**
+ * @brief /api/wifi/scan/result?job=N：查询扫描结果
+ *
+ * 扫描进行中返回 {"job":N,"done":false}，完成后返回
+ * {"job":N,"done":true,"items":[{"index":0,"ssid":"xxx","rssi":-60}, ...]}。
+ * 结果列表按 32 条上限申请，JSON 本身流式发出，不再需要整块输出缓冲。
+ */
+static esp_err_t web_module_scan_result_get_handler(httpd_req_t *req)
+{
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+
+    char query[32]  = {0};
+    char job_str[12] = {0};
+
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK ||
+        httpd_query_key_value(query, "job", job_str, sizeof(job_str)) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "job required");
         return ESP_OK;
     }
 
-    /* 序列化为形如 {"items":[{"index":0,"ssid":"xxx","rssi":-60}, ...]} 的 JSON
-     * 最多 32 条结果，每条包括 SSID 与 RSSI。为避免占用过多栈空间，
-     * 这里改为在堆上分配缓冲区。 */
-    const size_t json_buf_size = 3072; /* 足够容纳 32 条典型记录 */
-    char        *json          = (char *)malloc(json_buf_size);
-    if (json == NULL) {
+    uint32_t job_id = (uint32_t)strtoul(job_str, NULL, 10);
+
+    /* 使用堆缓冲区承载扫描结果，具体数量由回调实现控制 */
+    enum { WEB_MAX_SCAN_RESULT = 32 };
+    web_scan_result_t *list = (web_scan_result_t *)malloc(WEB_MAX_SCAN_RESULT * sizeof(web_scan_result_t));
+    if (list == NULL) {
         httpd_resp_send_err(req,
                             HTTPD_500_INTERNAL_SERVER_ERROR,
                             "no memory");
-        free(list);
         return ESP_OK;
     }
 
-    size_t offset = 0;
-
-    offset += (size_t)snprintf(json + offset, json_buf_size - offset, "{\"items\":[");
-
-    for (size_t i = 0; i < cnt && offset < json_buf_size; i++) {
-        const char *comma = (i == 0) ? "" : ",";
-        offset += (size_t)snprintf(json + offset,
-                                   json_buf_size - offset,
-                                   "%s{\"index\":%u,\"ssid\":\"%s\",\"rssi\":%d}",
-                                   comma,
-                                   (unsigned)i,
-                                   list[i].ssid,
-                                   (int)list[i].rssi);
-    }
-
-    if (offset >= json_buf_size) {
-        /* 理论上不会超出，若超出则截断为一个空列表作为兜底 */
-        const char *FALLBACK = "{\"items\":[]}";
-        httpd_resp_send(req, FALLBACK, strlen(FALLBACK));
+    size_t    cnt = WEB_MAX_SCAN_RESULT;
+    esp_err_t ret = s_web_cfg.scan_result_cb(job_id, list, &cnt);
+    if (ret != ESP_OK && ret != ESP_ERR_NOT_FINISHED) {
         free(list);
-        free(json);
+        if (ret == ESP_ERR_NOT_FOUND) {
+            httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "scan job not found");
+        } else {
+            httpd_resp_send_err(req,
+                                HTTPD_500_INTERNAL_SERVER_ERROR,
+                                "scan failed");
+        }
         return ESP_OK;
     }
 
-    offset += (size_t)snprintf(json + offset, json_buf_size - offset, "]}");
+    /* 流式序列化：扫描中仅返回 done:false，完成后附带结果列表 */
+    web_json_writer_t w;
+    web_json_init_resp(&w, req);
+    web_json_obj_begin(&w, NULL);
+    web_json_uint(&w, "job", job_id);
+    web_json_bool(&w, "done", ret == ESP_OK);
+    if (ret == ESP_OK) {
+        web_json_arr_begin(&w, "items");
+        for (size_t i = 0; i < cnt; i++) {
+            web_json_obj_begin(&w, NULL);
+            web_json_uint(&w, "index", (uint32_t)i);
+            web_json_str(&w, "ssid", list[i].ssid);
+            web_json_int(&w, "rssi", list[i].rssi);
+            web_json_obj_end(&w);
+        }
+        web_json_arr_end(&w);
+    }
+    web_json_obj_end(&w);
 
-    httpd_resp_send(req, json, (int)offset);
-    free(json);
     free(list);
-    return ESP_OK;
+    return web_json_finish(&w);
 }
 
 /**
@@ -425,26 +1114,20 @@ static esp_err_t web_module_connect_handler(httpd_req_t *req)
         return ESP_OK;
     }
 
-    char query[160]   = {0};
-    char ssid[32]     = {0};
-    char password[64] = {0};
+    char query[WEB_QUERY_CREDENTIALS_MAX] = {0};
+    char ssid[33]                         = {0};
+    char password[65]                     = {0};
 
     if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "missing query");
         return ESP_OK;
     }
 
-    if (httpd_query_key_value(query, "ssid", ssid, sizeof(ssid)) != ESP_OK) {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "missing ssid");
+    if (!web_query_get_ssid(req, query, ssid)) {
         return ESP_OK;
     }
-    (void)httpd_query_key_value(query, "password", password, sizeof(password));
-
-    web_url_decode_inplace(ssid);
-    web_url_decode_inplace(password);
-
-    if (ssid[0] == '\0') {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "missing ssid");
+    if (web_query_get_decoded(query, "password", password, sizeof(password)) == ESP_ERR_INVALID_SIZE) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "password too long");
         return ESP_OK;
     }
 
@@ -474,23 +1157,15 @@ static esp_err_t web_module_saved_delete_handler(httpd_req_t *req)
     }
 
     /* 解析 URL 查询字符串中的 ssid 参数 */
-    char  query[64] = {0};
-    char  ssid[32]  = {0};
+    char query[WEB_QUERY_SSID_MAX] = {0};
+    char ssid[33]                  = {0};
 
     if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "missing query");
         return ESP_OK;
     }
 
-    if (httpd_query_key_value(query, "ssid", ssid, sizeof(ssid)) != ESP_OK) {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "missing ssid");
-        return ESP_OK;
-    }
-
-    web_url_decode_inplace(ssid);
-
-    if (ssid[0] == '\0') {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "missing ssid");
+    if (!web_query_get_ssid(req, query, ssid)) {
         return ESP_OK;
     }
 
@@ -521,23 +1196,15 @@ static esp_err_t web_module_saved_connect_handler(httpd_req_t *req)
     }
 
     /* 解析 URL 查询字符串中的 ssid 参数 */
-    char query[64] = {0};
-    char ssid[32]  = {0};
+    char query[WEB_QUERY_SSID_MAX] = {0};
+    char ssid[33]                  = {0};
 
     if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "missing query");
         return ESP_OK;
     }
 
-    if (httpd_query_key_value(query, "ssid", ssid, sizeof(ssid)) != ESP_OK) {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "missing ssid");
-        return ESP_OK;
-    }
-
-    web_url_decode_inplace(ssid);
-
-    if (ssid[0] == '\0') {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "missing ssid");
+    if (!web_query_get_ssid(req, query, ssid)) {
         return ESP_OK;
     }
 
@@ -554,6 +1221,342 @@ static esp_err_t web_module_saved_connect_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
+/* -------------------- 分块文本输出 -------------------- */
+
+/* 文本输出缓冲：攒满一块再发送，避免每行一次 send（监控指标、导出共用） */
+#define WEB_TEXT_CHUNK_SIZE 512
+
+typedef struct {
+    httpd_req_t *req;
+    size_t       len;
+    char         buf[WEB_TEXT_CHUNK_SIZE];
+} web_text_sink_t;
+
+static esp_err_t web_module_text_flush(web_text_sink_t *sink)
+{
+    if (sink->len == 0) {
+        return ESP_OK;
+    }
+    esp_err_t ret = httpd_resp_send_chunk(sink->req, sink->buf, (ssize_t)sink->len);
+    sink->len = 0;
+    return ret;
+}
+
+static esp_err_t web_module_text_write(void *ctx, const char *data, size_t len)
+{
+    web_text_sink_t *sink = (web_text_sink_t *)ctx;
+
+    while (len > 0) {
+        size_t n = sizeof(sink->buf) - sink->len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(sink->buf + sink->len, data, n);
+        sink->len += n;
+        data      += n;
+        len       -= n;
+
+        if (sink->len == sizeof(sink->buf)) {
+            esp_err_t ret = web_module_text_flush(sink);
+            if (ret != ESP_OK) {
+                return ret;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+/* -------------------- 监控指标 -------------------- */
+
+/**
+ * @brief /api/metrics：以 Prometheus 文本格式输出监控指标（可选）
+ */
+static esp_err_t web_module_metrics_get_handler(httpd_req_t *req)
+{
+    web_text_sink_t *sink = (web_text_sink_t *)malloc(sizeof(web_text_sink_t));
+    if (sink == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "no memory");
+        return ESP_OK;
+    }
+    sink->req = req;
+    sink->len = 0;
+
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+
+    esp_err_t ret = s_web_cfg.metrics_cb(web_module_text_write, sink);
+    if (ret == ESP_OK) {
+        ret = web_module_asset_stats_write(web_module_text_write, sink);
+    }
+    if (ret == ESP_OK) {
+        ret = web_module_text_flush(sink);
+    }
+    free(sink);
+
+    if (ret != ESP_OK) {
+        /* 头部可能已发出，无法再返回错误页，直接结束本次连接 */
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/* -------------------- 已保存 WiFi 导入 / 导出 -------------------- */
+
+/*
+ * 导入与导出使用同一种表单格式："ssid=A&password=a&ssid=B&password=b"，按优先级排列。
+ * 每个 ssid 字段开始一条新网络，其后的 password 字段属于该网络（可省略），其它字段忽略。
+ */
+#define WEB_IMPORT_FIELD_MAX (9 + 64 * 3 + 1)   /* "password=" + 64 字节密码全部 %XX 编码 */
+#define WEB_IMPORT_GROW_MIN  8                  /* 条目数组首次分配的容量，之后按倍数扩容 */
+
+/* 解析过程中内存不足（返回 500，其余解析错误返回 400） */
+static const char WEB_IMPORT_ERR_NO_MEM[] = "no memory";
+
+typedef struct {
+    web_saved_import_item_t *items;             /* 按实际条目数扩容，不预先分配上限 */
+    size_t                   count;
+    size_t                   cap;
+    size_t                   field_len;
+    char                     field[WEB_IMPORT_FIELD_MAX];
+} web_import_parser_t;
+
+/**
+ * @brief 处理一个完整的 "key=value" 字段
+ *
+ * @return NULL 表示成功，否则为错误说明
+ */
+static const char *web_import_field_done(web_import_parser_t *p)
+{
+    if (p->field_len == 0) {
+        return NULL;
+    }
+    p->field[p->field_len] = '\0';
+    p->field_len           = 0;
+
+    char *value = strchr(p->field, '=');
+    if (value == NULL) {
+        return NULL;
+    }
+    *value++ = '\0';
+    web_url_decode_inplace(value);
+
+    if (strcmp(p->field, "ssid") == 0) {
+        if (p->count >= WEB_SAVED_IMPORT_MAX_ITEMS) {
+            return "too many networks";
+        }
+        if (p->count == p->cap) {
+            size_t cap = (p->cap == 0) ? WEB_IMPORT_GROW_MIN : p->cap * 2;
+            if (cap > WEB_SAVED_IMPORT_MAX_ITEMS) {
+                cap = WEB_SAVED_IMPORT_MAX_ITEMS;
+            }
+            web_saved_import_item_t *items =
+                (web_saved_import_item_t *)realloc(p->items, cap * sizeof(web_saved_import_item_t));
+            if (items == NULL) {
+                return WEB_IMPORT_ERR_NO_MEM;
+            }
+            p->items = items;
+            p->cap   = cap;
+        }
+        size_t len = strlen(value);
+        if (len == 0 || len > 32) {
+            return "invalid ssid";
+        }
+        web_saved_import_item_t *item = &p->items[p->count++];
+        memset(item, 0, sizeof(*item));
+        memcpy(item->ssid, value, len);
+    } else if (strcmp(p->field, "password") == 0) {
+        size_t len = strlen(value);
+        if (p->count == 0 || len > 64) {
+            return "invalid password";
+        }
+        memcpy(p->items[p->count - 1].password, value, len + 1);
+    }
+    return NULL;
+}
+
+/**
+ * @brief 解析一段请求体（字段可跨越多段）
+ */
+static const char *web_import_feed(web_import_parser_t *p, const char *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] == '&') {
+            const char *err = web_import_field_done(p);
+            if (err != NULL) {
+                return err;
+            }
+        } else if (data[i] != '\r' && data[i] != '\n') {
+            if (p->field_len + 1 >= sizeof(p->field)) {
+                return "field too long";
+            }
+            p->field[p->field_len++] = data[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief /api/wifi/saved/import[?replace=1]：批量保存 WiFi（不连接）
+ *
+ * 请求体为上述表单格式，流式解析（只缓存当前字段），全部解析成功后一次交给上层保存。
+ * 默认合并到已保存列表最前，replace=1 时替换整个列表。
+ * 返回 {"ok":true,"count":N}，N 为请求中的网络数。
+ */
+static esp_err_t web_module_saved_import_handler(httpd_req_t *req)
+{
+    char query[32]      = {0};
+    char replace_str[8] = {0};
+    bool replace        = false;
+
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "replace", replace_str, sizeof(replace_str)) == ESP_OK) {
+        replace = (strcmp(replace_str, "1") == 0 || strcmp(replace_str, "true") == 0);
+    }
+
+    if (req->content_len > WEB_SAVED_IMPORT_MAX_BODY) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "body too large");
+        return ESP_OK;
+    }
+
+    web_import_parser_t *p = (web_import_parser_t *)calloc(1, sizeof(web_import_parser_t));
+    if (p == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "no memory");
+        return ESP_OK;
+    }
+
+    const char *err       = NULL;
+    size_t      remaining = req->content_len;
+    char        buf[128];
+    while (remaining > 0 && err == NULL) {
+        int n = httpd_req_recv(req, buf, (remaining < sizeof(buf)) ? remaining : sizeof(buf));
+        if (n == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+        }
+        if (n <= 0) {
+            /* 连接已断开，无法再返回响应 */
+            free(p->items);
+            free(p);
+            return ESP_FAIL;
+        }
+        remaining -= (size_t)n;
+        err = web_import_feed(p, buf, (size_t)n);
+    }
+    if (err == NULL) {
+        err = web_import_field_done(p);
+    }
+
+    esp_err_t ret = ESP_OK;
+    if (err == NULL) {
+        ret = s_web_cfg.import_saved_cb(p->items, p->count, replace);
+    }
+    size_t count = p->count;
+    free(p->items);
+    free(p);
+
+    if (err == WEB_IMPORT_ERR_NO_MEM) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, err);
+        return ESP_OK;
+    }
+    if (err != NULL) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, err);
+        return ESP_OK;
+    }
+    if (ret == ESP_ERR_INVALID_ARG || ret == ESP_ERR_INVALID_SIZE) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "invalid list");
+        return ESP_OK;
+    }
+    if (ret != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "import failed");
+        return ESP_OK;
+    }
+
+    web_json_writer_t w;
+    web_json_init_resp(&w, req);
+    web_json_obj_begin(&w, NULL);
+    web_json_bool(&w, "ok", true);
+    web_json_uint(&w, "count", (uint32_t)count);
+    web_json_obj_end(&w);
+    return web_json_finish(&w);
+}
+
+typedef struct {
+    web_text_sink_t sink;
+    bool            first;
+} web_export_ctx_t;
+
+/**
+ * @brief 以 URL 编码写出字符串（只保留非保留字符，其余按 %XX 编码）
+ */
+static esp_err_t web_export_write_encoded(web_text_sink_t *sink, const char *str)
+{
+    static const char hex[] = "0123456789ABCDEF";
+
+    for (; *str != '\0'; str++) {
+        unsigned char c = (unsigned char)*str;
+        esp_err_t     ret;
+        if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            ret = web_module_text_write(sink, (const char *)&c, 1);
+        } else {
+            char esc[3] = { '%', hex[c >> 4], hex[c & 0x0F] };
+            ret = web_module_text_write(sink, esc, sizeof(esc));
+        }
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t web_export_emit(void *ctx, const char *ssid, const char *password)
+{
+    web_export_ctx_t *ex  = (web_export_ctx_t *)ctx;
+    const char       *sep = ex->first ? "ssid=" : "&ssid=";
+    ex->first             = false;
+
+    esp_err_t ret = web_module_text_write(&ex->sink, sep, strlen(sep));
+    if (ret == ESP_OK) {
+        ret = web_export_write_encoded(&ex->sink, ssid);
+    }
+    if (ret == ESP_OK && password != NULL && password[0] != '\0') {
+        ret = web_module_text_write(&ex->sink, "&password=", strlen("&password="));
+        if (ret == ESP_OK) {
+            ret = web_export_write_encoded(&ex->sink, password);
+        }
+    }
+    return ret;
+}
+
+/**
+ * @brief /api/wifi/saved/export：按优先级导出已保存 WiFi（含密码，可直接用于导入）
+ */
+static esp_err_t web_module_saved_export_handler(httpd_req_t *req)
+{
+    web_export_ctx_t *ex = (web_export_ctx_t *)malloc(sizeof(web_export_ctx_t));
+    if (ex == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "no memory");
+        return ESP_OK;
+    }
+    ex->sink.req = req;
+    ex->sink.len = 0;
+    ex->first    = true;
+
+    httpd_resp_set_type(req, "application/x-www-form-urlencoded");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"wifi_saved.txt\"");
+
+    esp_err_t ret = s_web_cfg.export_saved_cb(web_export_emit, ex);
+    if (ret == ESP_OK) {
+        ret = web_module_text_flush(&ex->sink);
+    }
+    free(ex);
+
+    if (ret != ESP_OK) {
+        /* 头部可能已发出，无法再返回错误页，直接结束本次连接 */
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
 /* -------------------- HTTP 服务器启动 -------------------- */
 
 /**
@@ -564,7 +1567,10 @@ static esp_err_t web_module_start_server(void)
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
 
     /* 默认 max_uri_handlers 较小，这里适当调大以容纳所有静态资源与 API */
-    config.max_uri_handlers = 12;
+    config.max_uri_handlers = 16;
+
+    /* SSE 订阅连接需要在关闭时清理记录 */
+    config.close_fn = web_module_on_sock_close;
 
     if (s_web_cfg.http_port > 0) {
         config.server_port = (uint16_t)s_web_cfg.http_port;
@@ -584,39 +1590,16 @@ static esp_err_t web_module_start_server(void)
         return ret;
     }
 
-    /* 静态文件路由：根路径与 /index.html 指向同一处理函数 */
-    static const httpd_uri_t uri_root = {
-        .uri      = "/",
-        .method   = HTTP_GET,
-        .handler  = web_module_root_get_handler,
-        .user_ctx = NULL,
-    };
-
-    static const httpd_uri_t uri_index = {
-        .uri      = "/index.html",
-        .method   = HTTP_GET,
-        .handler  = web_module_root_get_handler,
-        .user_ctx = NULL,
-    };
-
-    static const httpd_uri_t uri_css = {
-        .uri      = "/app.css",
-        .method   = HTTP_GET,
-        .handler  = web_module_css_get_handler,
-        .user_ctx = NULL,
-    };
-
-    static const httpd_uri_t uri_js = {
-        .uri      = "/app.js",
-        .method   = HTTP_GET,
-        .handler  = web_module_js_get_handler,
-        .user_ctx = NULL,
-    };
-
-    httpd_register_uri_handler(s_http_server, &uri_root);
-    httpd_register_uri_handler(s_http_server, &uri_index);
-    httpd_register_uri_handler(s_http_server, &uri_css);
-    httpd_register_uri_handler(s_http_server, &uri_js);
+    /* 静态文件路由：按路由表逐条注册，user_ctx 指向对应路由 */
+    for (size_t i = 0; i < sizeof(s_web_asset_routes) / sizeof(s_web_asset_routes[0]); i++) {
+        httpd_uri_t uri_static = {
+            .uri      = s_web_asset_routes[i].uri,
+            .method   = HTTP_GET,
+            .handler  = web_module_static_get_handler,
+            .user_ctx = (void *)&s_web_asset_routes[i],
+        };
+        httpd_register_uri_handler(s_http_server, &uri_static);
+    }
 
     /* 仅在配置了回调的前提下注册状态接口，保持职责清晰 */
     if (s_web_cfg.get_status_cb != NULL) {
@@ -627,10 +1610,19 @@ static esp_err_t web_module_start_server(void)
             .user_ctx = NULL,
         };
         httpd_register_uri_handler(s_http_server, &uri_status);
+
+        /* 状态推送接口：与状态查询共用同一回调 */
+        static const httpd_uri_t uri_events = {
+            .uri      = "/api/wifi/events",
+            .method   = HTTP_GET,
+            .handler  = web_module_events_get_handler,
+            .user_ctx = NULL,
+        };
+        httpd_register_uri_handler(s_http_server, &uri_events);
     }
 
     /* 已保存 WiFi 列表接口（可选） */
-    if (s_web_cfg.get_saved_list_cb != NULL) {
+    if (s_web_cfg.foreach_saved_cb != NULL) {
         static const httpd_uri_t uri_saved = {
             .uri      = "/api/wifi/saved",
             .method   = HTTP_GET,
@@ -640,8 +1632,8 @@ static esp_err_t web_module_start_server(void)
         httpd_register_uri_handler(s_http_server, &uri_saved);
     }
 
-    /* 扫描附近 WiFi 接口（可选） */
-    if (s_web_cfg.scan_cb != NULL) {
+    /* 异步扫描接口（可选）：发起扫描 + 按任务编号查询结果 */
+    if (s_web_cfg.scan_start_cb != NULL && s_web_cfg.scan_result_cb != NULL) {
         static const httpd_uri_t uri_scan = {
             .uri      = "/api/wifi/scan",
             .method   = HTTP_GET,
@@ -649,6 +1641,14 @@ static esp_err_t web_module_start_server(void)
             .user_ctx = NULL,
         };
         httpd_register_uri_handler(s_http_server, &uri_scan);
+
+        static const httpd_uri_t uri_scan_result = {
+            .uri      = "/api/wifi/scan/result",
+            .method   = HTTP_GET,
+            .handler  = web_module_scan_result_get_handler,
+            .user_ctx = NULL,
+        };
+        httpd_register_uri_handler(s_http_server, &uri_scan_result);
     }
 
     /* 删除已保存 WiFi 接口（可选） */
@@ -684,6 +1684,37 @@ static esp_err_t web_module_start_server(void)
         httpd_register_uri_handler(s_http_server, &uri_saved_connect);
     }
 
+    /* 批量导入 / 导出已保存 WiFi 接口（可选） */
+    if (s_web_cfg.import_saved_cb != NULL) {
+        static const httpd_uri_t uri_saved_import = {
+            .uri      = "/api/wifi/saved/import",
+            .method   = HTTP_POST,
+            .handler  = web_module_saved_import_handler,
+            .user_ctx = NULL,
+        };
+        httpd_register_uri_handler(s_http_server, &uri_saved_import);
+    }
+    if (s_web_cfg.export_saved_cb != NULL) {
+        static const httpd_uri_t uri_saved_export = {
+            .uri      = "/api/wifi/saved/export",
+            .method   = HTTP_GET,
+            .handler  = web_module_saved_export_handler,
+            .user_ctx = NULL,
+        };
+        httpd_register_uri_handler(s_http_server, &uri_saved_export);
+    }
+
+    /* 监控指标接口（可选） */
+    if (s_web_cfg.metrics_cb != NULL) {
+        static const httpd_uri_t uri_metrics = {
+            .uri      = "/api/metrics",
+            .method   = HTTP_GET,
+            .handler  = web_module_metrics_get_handler,
+            .user_ctx = NULL,
+        };
+        httpd_register_uri_handler(s_http_server, &uri_metrics);
+    }
+
     return ESP_OK;
 }
 
@@ -703,7 +1734,8 @@ esp_err_t web_module_init(const web_module_config_t *config)
         return ESP_OK;
     }
 
-    esp_err_t ret = web_module_mount_spiffs();
+    /* 准备网页资源：嵌入固件 / 映射分区 / 挂载 SPIFFS（按 Kconfig 选择） */
+    esp_err_t ret = web_module_load_assets();
     if (ret != ESP_OK) {
         return ret;
     }
@@ -717,3 +1749,21 @@ esp_err_t web_module_init(const web_module_config_t *config)
     return ESP_OK;
 }
 
+esp_err_t web_module_notify_status(void)
+{
+    if (!s_web_inited || s_http_server == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    /* 无订阅者或已有推送在排队时无需重复排队（排队的推送会读取最新状态） */
+    if (s_web_event_clients <= 0 || s_web_event_pending) {
+        return ESP_OK;
+    }
+
+    s_web_event_pending = true;
+    esp_err_t ret = httpd_queue_work(s_http_server, web_module_events_push_work, NULL);
+    if (ret != ESP_OK) {
+        s_web_event_pending = false;
+    }
+    return ret;
+}
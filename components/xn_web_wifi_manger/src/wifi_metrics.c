@@ -0,0 +1,345 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-11-25 09:30:00
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-11-25 09:30:00
+ * @FilePath: \xn_web_wifi_config\components\xn_web_wifi_manger\src\wifi_metrics.c
+ * @Description: WiFi 连接耗时统计实现
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+
+#include "esp_timer.h"
+
+#include "wifi_metrics.h"
+
+/* 统计表（容量 s_metrics_cap），每个条目附带最近更新时间用于淘汰 */
+typedef struct {
+    wifi_metrics_entry_t data;
+    int64_t              last_us;
+    bool                 used;
+} wifi_metrics_slot_t;
+
+static portMUX_TYPE         s_metrics_lock = portMUX_INITIALIZER_UNLOCKED;
+static wifi_metrics_slot_t *s_metrics      = NULL;
+static size_t               s_metrics_cap  = 0;
+
+static const uint32_t s_bucket_bounds_ms[WIFI_METRICS_BUCKET_NUM - 1] = WIFI_METRICS_BUCKET_BOUNDS_MS;
+
+static const char *const s_phase_names[WIFI_METRICS_PHASE_NUM] = {
+    "assoc", "dhcp", "total", "recovery",
+};
+
+/* -------------------- 内部工具 -------------------- */
+
+/**
+ * @brief 查找或分配某个 SSID 的条目（调用方需持有 s_metrics_lock）
+ */
+static wifi_metrics_entry_t *wifi_metrics_slot(const char *ssid)
+{
+    wifi_metrics_slot_t *victim = NULL;
+
+    for (size_t i = 0; i < s_metrics_cap; i++) {
+        wifi_metrics_slot_t *slot = &s_metrics[i];
+        if (slot->used && strncmp(slot->data.ssid, ssid, sizeof(slot->data.ssid) - 1) == 0) {
+            slot->last_us = esp_timer_get_time();
+            return &slot->data;
+        }
+        if (!slot->used) {
+            if (victim == NULL || victim->used) {
+                victim = slot;
+            }
+        } else if (victim == NULL || (victim->used && slot->last_us < victim->last_us)) {
+            victim = slot;
+        }
+    }
+
+    if (victim == NULL) {
+        return NULL;
+    }
+
+    memset(victim, 0, sizeof(*victim));
+    strncpy(victim->data.ssid, ssid, sizeof(victim->data.ssid) - 1);
+    victim->used    = true;
+    victim->last_us = esp_timer_get_time();
+    return &victim->data;
+}
+
+/* -------------------- 对外接口 -------------------- */
+
+esp_err_t wifi_metrics_init(size_t max_ssids)
+{
+    if (s_metrics != NULL) {
+        return ESP_OK;
+    }
+    if (max_ssids == 0) {
+        max_ssids = 1;
+    }
+
+    s_metrics = (wifi_metrics_slot_t *)calloc(max_ssids, sizeof(wifi_metrics_slot_t));
+    if (s_metrics == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    s_metrics_cap = max_ssids;
+    return ESP_OK;
+}
+
+void wifi_metrics_observe(const char *ssid, wifi_metrics_phase_t phase, uint32_t ms)
+{
+    if (s_metrics == NULL || ssid == NULL || ssid[0] == '\0' || phase >= WIFI_METRICS_PHASE_NUM) {
+        return;
+    }
+
+    size_t bucket = 0;
+    while (bucket < WIFI_METRICS_BUCKET_NUM - 1 && ms > s_bucket_bounds_ms[bucket]) {
+        bucket++;
+    }
+
+    portENTER_CRITICAL(&s_metrics_lock);
+    wifi_metrics_entry_t *entry = wifi_metrics_slot(ssid);
+    if (entry != NULL) {
+        wifi_metrics_hist_t *hist = &entry->phase[phase];
+        hist->buckets[bucket]++;
+        hist->count++;
+        hist->sum_ms += ms;
+    }
+    portEXIT_CRITICAL(&s_metrics_lock);
+}
+
+void wifi_metrics_count(const char *ssid, wifi_metrics_counter_t counter)
+{
+    if (s_metrics == NULL || ssid == NULL || ssid[0] == '\0' || counter >= WIFI_METRICS_COUNTER_NUM) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_metrics_lock);
+    wifi_metrics_entry_t *entry = wifi_metrics_slot(ssid);
+    if (entry != NULL) {
+        entry->counter[counter]++;
+    }
+    portEXIT_CRITICAL(&s_metrics_lock);
+}
+
+esp_err_t wifi_metrics_get(wifi_metrics_entry_t *out, size_t *inout_cnt)
+{
+    if (inout_cnt == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_metrics == NULL) {
+        *inout_cnt = 0;
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    size_t n = 0;
+
+    portENTER_CRITICAL(&s_metrics_lock);
+    for (size_t i = 0; i < s_metrics_cap; i++) {
+        if (!s_metrics[i].used) {
+            continue;
+        }
+        if (out != NULL) {
+            if (n >= *inout_cnt) {
+                break;
+            }
+            out[n] = s_metrics[i].data;
+        }
+        n++;
+    }
+    portEXIT_CRITICAL(&s_metrics_lock);
+
+    *inout_cnt = n;
+    return ESP_OK;
+}
+
+void wifi_metrics_reset(void)
+{
+    if (s_metrics == NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_metrics_lock);
+    memset(s_metrics, 0, s_metrics_cap * sizeof(wifi_metrics_slot_t));
+    portEXIT_CRITICAL(&s_metrics_lock);
+}
+
+/* -------------------- Prometheus 导出 -------------------- */
+
+/**
+ * @brief 将 SSID 转义为 Prometheus 标签值（'\\'、'"'、换行）
+ */
+static void wifi_metrics_escape_label(char *dst, size_t size, const char *src)
+{
+    size_t n = 0;
+
+    for (; *src != '\0' && n + 2 < size; src++) {
+        char c = *src;
+        if (c == '\\' || c == '"') {
+            dst[n++] = '\\';
+            dst[n++] = c;
+        } else if (c == '\n') {
+            dst[n++] = '\\';
+            dst[n++] = 'n';
+        } else {
+            dst[n++] = c;
+        }
+    }
+    dst[n] = '\0';
+}
+
+/**
+ * @brief 格式化一行并输出
+ */
+static esp_err_t wifi_metrics_emit(wifi_metrics_write_fn_t write, void *ctx, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+static esp_err_t wifi_metrics_emit(wifi_metrics_write_fn_t write, void *ctx, const char *fmt, ...)
+{
+    char    line[256];
+    va_list ap;
+
+    va_start(ap, fmt);
+    int len = vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+
+    if (len < 0) {
+        return ESP_FAIL;
+    }
+    if ((size_t)len >= sizeof(line)) {
+        len = sizeof(line) - 1;
+    }
+    return write(ctx, line, (size_t)len);
+}
+
+/**
+ * @brief 在锁内复制一个槽位
+ *
+ * @return 槽位是否在用
+ */
+static bool wifi_metrics_copy_slot(size_t i, wifi_metrics_entry_t *out)
+{
+    bool used;
+
+    portENTER_CRITICAL(&s_metrics_lock);
+    used = s_metrics[i].used;
+    if (used) {
+        *out = s_metrics[i].data;
+    }
+    portEXIT_CRITICAL(&s_metrics_lock);
+
+    return used;
+}
+
+/**
+ * @brief 输出单个 SSID 的直方图行
+ */
+static esp_err_t wifi_metrics_write_entry(wifi_metrics_write_fn_t write, void *ctx,
+                                          const wifi_metrics_entry_t *entry)
+{
+    char      ssid[sizeof(entry->ssid) * 2];
+    esp_err_t ret = ESP_OK;
+
+    wifi_metrics_escape_label(ssid, sizeof(ssid), entry->ssid);
+
+    for (int p = 0; p < WIFI_METRICS_PHASE_NUM && ret == ESP_OK; p++) {
+        const wifi_metrics_hist_t *hist = &entry->phase[p];
+        uint32_t                   cum  = 0;
+
+        if (hist->count == 0) {
+            continue;
+        }
+
+        for (int b = 0; b < WIFI_METRICS_BUCKET_NUM && ret == ESP_OK; b++) {
+            cum += hist->buckets[b];
+            if (b < WIFI_METRICS_BUCKET_NUM - 1) {
+                uint32_t bound = s_bucket_bounds_ms[b];
+                ret = wifi_metrics_emit(write, ctx,
+                                        "wifi_connect_phase_seconds_bucket{ssid=\"%s\",phase=\"%s\",le=\"%lu.%03lu\"} %lu\n",
+                                        ssid, s_phase_names[p],
+                                        (unsigned long)(bound / 1000), (unsigned long)(bound % 1000),
+                                        (unsigned long)cum);
+            } else {
+                ret = wifi_metrics_emit(write, ctx,
+                                        "wifi_connect_phase_seconds_bucket{ssid=\"%s\",phase=\"%s\",le=\"+Inf\"} %lu\n",
+                                        ssid, s_phase_names[p], (unsigned long)cum);
+            }
+        }
+        if (ret == ESP_OK) {
+            ret = wifi_metrics_emit(write, ctx,
+                                    "wifi_connect_phase_seconds_sum{ssid=\"%s\",phase=\"%s\"} %llu.%03llu\n",
+                                    ssid, s_phase_names[p],
+                                    (unsigned long long)(hist->sum_ms / 1000),
+                                    (unsigned long long)(hist->sum_ms % 1000));
+        }
+        if (ret == ESP_OK) {
+            ret = wifi_metrics_emit(write, ctx,
+                                    "wifi_connect_phase_seconds_count{ssid=\"%s\",phase=\"%s\"} %lu\n",
+                                    ssid, s_phase_names[p], (unsigned long)hist->count);
+        }
+    }
+
+    return ret;
+}
+
+esp_err_t wifi_metrics_write_prometheus(wifi_metrics_write_fn_t write, void *ctx)
+{
+    if (write == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_metrics == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    /* 逐条复制后在锁外格式化，输出回调可能较慢（如网络发送） */
+    esp_err_t ret = wifi_metrics_emit(write, ctx, "%s",
+                                      "# HELP wifi_connect_phase_seconds WiFi connect phase latency.\n"
+                                      "# TYPE wifi_connect_phase_seconds histogram\n");
+
+    wifi_metrics_entry_t entry;
+    for (size_t i = 0; i < s_metrics_cap && ret == ESP_OK; i++) {
+        if (wifi_metrics_copy_slot(i, &entry)) {
+            ret = wifi_metrics_write_entry(write, ctx, &entry);
+        }
+    }
+
+    if (ret == ESP_OK) {
+        ret = wifi_metrics_emit(write, ctx, "%s",
+                                "# HELP wifi_connect_total WiFi connect attempts by result.\n"
+                                "# TYPE wifi_connect_total counter\n");
+    }
+    for (size_t i = 0; i < s_metrics_cap && ret == ESP_OK; i++) {
+        if (!wifi_metrics_copy_slot(i, &entry)) {
+            continue;
+        }
+
+        char ssid[sizeof(entry.ssid) * 2];
+        wifi_metrics_escape_label(ssid, sizeof(ssid), entry.ssid);
+        ret = wifi_metrics_emit(write, ctx,
+                                "wifi_connect_total{ssid=\"%s\",result=\"ok\"} %lu\n"
+                                "wifi_connect_total{ssid=\"%s\",result=\"fail\"} %lu\n",
+                                ssid, (unsigned long)entry.counter[WIFI_METRICS_COUNTER_CONNECT_OK],
+                                ssid, (unsigned long)entry.counter[WIFI_METRICS_COUNTER_CONNECT_FAIL]);
+    }
+
+    if (ret == ESP_OK) {
+        ret = wifi_metrics_emit(write, ctx, "%s",
+                                "# HELP wifi_disconnect_total WiFi link losses after connect.\n"
+                                "# TYPE wifi_disconnect_total counter\n");
+    }
+    for (size_t i = 0; i < s_metrics_cap && ret == ESP_OK; i++) {
+        if (!wifi_metrics_copy_slot(i, &entry)) {
+            continue;
+        }
+
+        char ssid[sizeof(entry.ssid) * 2];
+        wifi_metrics_escape_label(ssid, sizeof(ssid), entry.ssid);
+        ret = wifi_metrics_emit(write, ctx, "wifi_disconnect_total{ssid=\"%s\"} %lu\n",
+                                ssid, (unsigned long)entry.counter[WIFI_METRICS_COUNTER_DISCONNECT]);
+    }
+
+    return ret;
+}
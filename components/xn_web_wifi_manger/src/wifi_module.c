@@ -9,14 +9,17 @@
  * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved. 
  */
 
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 
 #include "esp_event.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_netif.h"
 #include "esp_wifi.h"
 #include "nvs_flash.h"
@@ -39,16 +42,212 @@ static bool s_connecting = false;
 static esp_netif_t *s_sta_netif = NULL;
 static esp_netif_t *s_ap_netif  = NULL;
 
+/* -------------------- 状态快照（顺序锁） -------------------- */
+
+/*
+ * 写侧：事件循环任务（WiFi / IP 事件）与 esp_timer 任务（RSSI 采样），
+ *       通过自旋锁互斥，写入期间 s_status_seq 为奇数；
+ * 读侧：wifi_module_get_status() 无锁拷贝，前后两次读取的序号相同且为偶数时
+ *       说明拷贝期间没有写入，否则重试。
+ */
+static wifi_module_status_t s_status;
+static uint32_t             s_status_seq  = 0;
+static portMUX_TYPE         s_status_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* RSSI 周期采样定时器（仅在 STA 已连接期间运行） */
+static esp_timer_handle_t s_rssi_timer = NULL;
+
+/* -------------------- 异步扫描 -------------------- */
+
+/* 同步扫描封装等待 SCAN_DONE 的超时时间 */
+#define WIFI_MODULE_SCAN_TIMEOUT_MS 10000
+
+/*
+ * 扫描状态与结果由 s_scan_lock 保护：
+ *  - 写侧：wifi_module_scan_start()（调用方任务）与 SCAN_DONE 事件（事件循环任务）；
+ *  - 读侧：wifi_module_scan_get_results()，只做一次短拷贝。
+ */
+static portMUX_TYPE               s_scan_lock        = portMUX_INITIALIZER_UNLOCKED;
+static bool                       s_scan_running     = false; /* 是否有扫描进行中 */
+static uint32_t                   s_scan_id          = 0;     /* 最近一次发起的扫描编号 */
+static uint32_t                   s_scan_done_id     = 0;     /* 最近一次完成的扫描编号 */
+static esp_err_t                  s_scan_done_status = ESP_OK;
+static int64_t                    s_scan_done_us     = 0;     /* 最近一次完成的时间 */
+static uint16_t                   s_scan_count       = 0;
+static wifi_module_scan_result_t  s_scan_results[WIFI_MODULE_SCAN_MAX_RESULTS];
+
+/* 扫描完成信号，供同步扫描封装等待 */
+static SemaphoreHandle_t          s_scan_done_sem    = NULL;
+
+static void wifi_module_status_write_begin(void)
+{
+    portENTER_CRITICAL(&s_status_lock);
+    __atomic_store_n(&s_status_seq, s_status_seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void wifi_module_status_write_end(void)
+{
+    __atomic_store_n(&s_status_seq, s_status_seq + 1, __ATOMIC_RELEASE);
+    portEXIT_CRITICAL(&s_status_lock);
+}
+
+/**
+ * @brief 清除快照中与 STA 连接相关的字段（断开时调用）
+ */
+static void wifi_module_status_clear_sta(void)
+{
+    wifi_module_status_write_begin();
+    s_status.sta_connected = false;
+    s_status.sta_got_ip    = false;
+    s_status.ssid[0]       = '\0';
+    memset(s_status.bssid, 0, sizeof(s_status.bssid));
+    s_status.channel       = 0;
+    s_status.authmode      = WIFI_AUTH_OPEN;
+    s_status.rssi          = 0;
+    s_status.ip[0]         = '\0';
+    wifi_module_status_write_end();
+}
+
+/**
+ * @brief 更新快照中的工作模式
+ */
+static void wifi_module_status_set_mode(wifi_mode_t mode)
+{
+    wifi_module_status_write_begin();
+    s_status.mode = mode;
+    wifi_module_status_write_end();
+}
+
 /**
  * @brief 统一转发 WiFi 模块事件到上层回调
  */
-static void wifi_module_handle_event(wifi_module_event_t event)
+static void wifi_module_handle_event(wifi_module_event_t event, uint16_t reason)
 {
     if (s_wifi_cfg.event_cb) {
-        s_wifi_cfg.event_cb(event);
+        s_wifi_cfg.event_cb(event, reason);
+    }
+}
+
+/**
+ * @brief RSSI 采样定时器回调（esp_timer 任务上下文）
+ *
+ * 读取当前 RSSI 写入快照；与上次上报值相差达到 rssi_notify_delta 时上报事件。
+ */
+static void wifi_module_rssi_timer_cb(void *arg)
+{
+    (void)arg;
+
+    static int8_t s_reported_rssi = 0;
+
+    int rssi = 0;
+    if (esp_wifi_sta_get_rssi(&rssi) != ESP_OK) {
+        return;
+    }
+
+    wifi_module_status_write_begin();
+    bool connected = s_status.sta_connected;
+    if (connected) {
+        s_status.rssi = (int8_t)rssi;
+    }
+    wifi_module_status_write_end();
+
+    if (!connected) {
+        return;
+    }
+
+    int delta = rssi - (int)s_reported_rssi;
+    if (delta < 0) {
+        delta = -delta;
+    }
+    if (delta >= (int)s_wifi_cfg.rssi_notify_delta) {
+        s_reported_rssi = (int8_t)rssi;
+        wifi_module_handle_event(WIFI_MODULE_EVENT_STA_RSSI_CHANGED, 0);
     }
 }
 
+/**
+ * @brief 启动 / 停止 RSSI 周期采样
+ */
+static void wifi_module_rssi_sampler_enable(bool enable)
+{
+    if (s_rssi_timer == NULL) {
+        return;
+    }
+
+    (void)esp_timer_stop(s_rssi_timer);
+    if (enable) {
+        (void)esp_timer_start_periodic(s_rssi_timer,
+                                       (uint64_t)s_wifi_cfg.rssi_sample_interval_ms * 1000ULL);
+    }
+}
+
+/**
+ * @brief 处理扫描完成事件（事件循环任务上下文）
+ *
+ * 从驱动取出扫描记录并转换为精简结果保存，驱动内部缓存随之释放；
+ * 无论成功与否都结束本次扫描并上报 WIFI_MODULE_EVENT_SCAN_DONE。
+ */
+static void wifi_module_on_scan_done(const wifi_event_sta_scan_done_t *info)
+{
+    uint16_t          ap_num  = 0;
+    wifi_ap_record_t *ap_list = NULL;
+    esp_err_t         ret     = ESP_FAIL;
+
+    if (info != NULL && info->status == 0) {
+        ret = esp_wifi_scan_get_ap_num(&ap_num);
+    }
+
+    if (ret == ESP_OK && ap_num > 0) {
+        if (ap_num > WIFI_MODULE_SCAN_MAX_RESULTS) {
+            ap_num = WIFI_MODULE_SCAN_MAX_RESULTS;
+        }
+        ap_list = calloc(ap_num, sizeof(wifi_ap_record_t));
+        ret     = (ap_list != NULL) ? esp_wifi_scan_get_ap_records(&ap_num, ap_list)
+                                    : ESP_ERR_NO_MEM;
+    }
+
+    if (ap_list == NULL || ret != ESP_OK) {
+        /* 未成功读取记录时由这里释放驱动缓存的扫描结果 */
+        (void)esp_wifi_clear_ap_list();
+        ap_num = 0;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_scan_lock);
+    for (uint16_t i = 0; i < ap_num; ++i) {
+        /* ap_list[i].ssid 为 33 字节（32 字节 SSID + '\0'），完整保留 32 字节的 SSID */
+        memset(s_scan_results[i].ssid, 0, sizeof(s_scan_results[i].ssid));
+        strncpy(s_scan_results[i].ssid,
+                (const char *)ap_list[i].ssid,
+                sizeof(s_scan_results[i].ssid) - 1);
+        s_scan_results[i].rssi     = ap_list[i].rssi;
+        memcpy(s_scan_results[i].bssid, ap_list[i].bssid, sizeof(s_scan_results[i].bssid));
+        s_scan_results[i].channel  = ap_list[i].primary;
+        s_scan_results[i].authmode = ap_list[i].authmode;
+    }
+    s_scan_count       = ap_num;
+    s_scan_done_status = ret;
+    s_scan_done_id     = s_scan_id;
+    s_scan_done_us     = now_us;
+    s_scan_running     = false;
+    portEXIT_CRITICAL(&s_scan_lock);
+
+    free(ap_list);
+
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "wifi scan done: found %u AP(s)", (unsigned)ap_num);
+    } else {
+        ESP_LOGW(TAG, "wifi scan failed: %s", esp_err_to_name(ret));
+    }
+
+    if (s_scan_done_sem != NULL) {
+        (void)xSemaphoreGive(s_scan_done_sem);
+    }
+    wifi_module_handle_event(WIFI_MODULE_EVENT_SCAN_DONE, 0);
+}
+
 /**
  * @brief WiFi 事件回调
  *
@@ -60,7 +259,6 @@ static void wifi_module_event_handler(void *arg,
                                       void *event_data)
 {
     (void)arg;
-    (void)event_data;
 
     if (event_base != WIFI_EVENT) {
         return;
@@ -72,7 +270,8 @@ static void wifi_module_event_handler(void *arg,
         break;
 
     case WIFI_EVENT_SCAN_DONE:
-        /* 扫描完成（wifi_module_scan 为同步扫描，此处通常也不处理） */
+        /* 异步扫描完成，保存结果并通知上层 */
+        wifi_module_on_scan_done((const wifi_event_sta_scan_done_t *)event_data);
         break;
 
     case WIFI_EVENT_STA_START:
@@ -83,24 +282,62 @@ static void wifi_module_event_handler(void *arg,
         /* STA 接口已停止 */
         break;
 
-    case WIFI_EVENT_STA_CONNECTED:
+    case WIFI_EVENT_STA_CONNECTED: {
         /* STA 已与 AP 建立连接（不一定拿到 IP） */
+        const wifi_event_sta_connected_t *info = (const wifi_event_sta_connected_t *)event_data;
+
+        /* 驱动调用放在快照写入临界区之外 */
+        int rssi = 0;
+        (void)esp_wifi_sta_get_rssi(&rssi);
+
+        wifi_module_status_write_begin();
+        s_status.sta_connected = true;
+        if (info != NULL) {
+            size_t len = (info->ssid_len < sizeof(s_status.ssid) - 1) ? info->ssid_len
+                                                                      : sizeof(s_status.ssid) - 1;
+            memcpy(s_status.ssid, info->ssid, len);
+            s_status.ssid[len] = '\0';
+            memcpy(s_status.bssid, info->bssid, sizeof(s_status.bssid));
+            s_status.channel  = info->channel;
+            s_status.authmode = info->authmode;
+        }
+        s_status.rssi = (int8_t)rssi;
+        s_status.timing.connected_us = esp_timer_get_time();
+        wifi_module_status_write_end();
+
+        wifi_module_rssi_sampler_enable(true);
+
         s_connecting = false;
-        wifi_module_handle_event(WIFI_MODULE_EVENT_STA_CONNECTED);
+        wifi_module_handle_event(WIFI_MODULE_EVENT_STA_CONNECTED, 0);
         break;
+    }
 
-    case WIFI_EVENT_STA_DISCONNECTED:
+    case WIFI_EVENT_STA_DISCONNECTED: {
         /* STA 断开：
          * - 若当前标记为“正在连接”，视为本次连接尝试失败；
          * - 否则视为已连接后意外断开。
+         * 两种情况都带上驱动给出的原因码，由上层区分认证失败 / 找不到 AP / 临时性故障。
          */
+        const wifi_event_sta_disconnected_t *info = (const wifi_event_sta_disconnected_t *)event_data;
+        uint16_t reason = (info != NULL) ? (uint16_t)info->reason : 0;
+
+        wifi_module_rssi_sampler_enable(false);
+        wifi_module_status_clear_sta();
+
+        wifi_module_status_write_begin();
+        s_status.timing.disconnected_us = esp_timer_get_time();
+        wifi_module_status_write_end();
+
         if (s_connecting) {
             s_connecting = false;
-            wifi_module_handle_event(WIFI_MODULE_EVENT_STA_CONNECT_FAILED);
+            ESP_LOGW(TAG, "sta connect failed, reason=%u", (unsigned)reason);
+            wifi_module_handle_event(WIFI_MODULE_EVENT_STA_CONNECT_FAILED, reason);
         } else {
-            wifi_module_handle_event(WIFI_MODULE_EVENT_STA_DISCONNECTED);
+            ESP_LOGW(TAG, "sta disconnected, reason=%u", (unsigned)reason);
+            wifi_module_handle_event(WIFI_MODULE_EVENT_STA_DISCONNECTED, reason);
         }
         break;
+    }
 
     case WIFI_EVENT_STA_AUTHMODE_CHANGE:
         /* AP 加密方式变化（一般无需处理） */
@@ -151,21 +388,38 @@ static void wifi_module_ip_event_handler(void *arg,
                                          void *event_data)
 {
     (void)arg;
-    (void)event_data;
 
     if (event_base != IP_EVENT) {
         return;
     }
 
     switch (event_id) {
-    case IP_EVENT_STA_GOT_IP:
+    case IP_EVENT_STA_GOT_IP: {
         /* STA 获取到 IPv4 地址，视为 WiFi 完全连接成功 */
+        const ip_event_got_ip_t *info = (const ip_event_got_ip_t *)event_data;
+        char                     ip[16] = {0};
+
+        if (info != NULL) {
+            snprintf(ip, sizeof(ip), IPSTR, IP2STR(&info->ip_info.ip));
+        }
+
+        wifi_module_status_write_begin();
+        s_status.sta_got_ip = true;
+        memcpy(s_status.ip, ip, sizeof(s_status.ip));
+        s_status.timing.got_ip_us = esp_timer_get_time();
+        wifi_module_status_write_end();
+
         s_connecting = false;
-        wifi_module_handle_event(WIFI_MODULE_EVENT_STA_GOT_IP);
+        wifi_module_handle_event(WIFI_MODULE_EVENT_STA_GOT_IP, 0);
         break;
+    }
 
     case IP_EVENT_STA_LOST_IP:
-        /* STA 丢失 IPv4 地址，可视场景决定是否上报给上层 */
+        /* STA 丢失 IPv4 地址：仅更新快照，是否重连由断开事件驱动 */
+        wifi_module_status_write_begin();
+        s_status.sta_got_ip = false;
+        s_status.ip[0]      = '\0';
+        wifi_module_status_write_end();
         break;
 
     case IP_EVENT_AP_STAIPASSIGNED:
@@ -288,6 +542,7 @@ esp_err_t wifi_module_init(const wifi_module_config_t *config)
             ESP_LOGE(TAG, "esp_wifi_set_mode failed: %s", esp_err_to_name(ret));
             return ret;
         }
+        wifi_module_status_set_mode(mode);
     }
 
     /* 7. 如启用 AP，配置 AP 参数 */
@@ -340,7 +595,30 @@ esp_err_t wifi_module_init(const wifi_module_config_t *config)
         return ret;
     }
 
-    /* 9. 启动 WiFi 驱动 */
+    /* 9. 创建 RSSI 采样定时器（STA 连接后启动） */
+    if (s_rssi_timer == NULL && s_wifi_cfg.rssi_sample_interval_ms > 0) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = wifi_module_rssi_timer_cb,
+            .arg      = NULL,
+            .name     = "wifi_rssi",
+        };
+        ret = esp_timer_create(&timer_args, &s_rssi_timer);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "rssi timer create failed: %s", esp_err_to_name(ret));
+            return ret;
+        }
+    }
+
+    /* 10. 创建扫描完成信号量（供同步扫描封装等待） */
+    if (s_scan_done_sem == NULL) {
+        s_scan_done_sem = xSemaphoreCreateBinary();
+        if (s_scan_done_sem == NULL) {
+            ESP_LOGE(TAG, "scan semaphore create failed");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    /* 11. 启动 WiFi 驱动 */
     ret = esp_wifi_start();
     if (ret != ESP_OK && ret != ESP_ERR_WIFI_CONN) {
         ESP_LOGE(TAG, "esp_wifi_start failed: %s", esp_err_to_name(ret));
@@ -358,6 +636,20 @@ esp_err_t wifi_module_init(const wifi_module_config_t *config)
  * @param password AP 密码，可为 NULL/空串 表示开放网络
  */
 esp_err_t wifi_module_connect(const char *ssid, const char *password)
+{
+    return wifi_module_connect_with_hint(ssid, password, NULL);
+}
+
+/**
+ * @brief 以 STA 模式连接指定 AP，可选锁定 BSSID / 信道
+ *
+ * @param ssid     目标 AP SSID，必须非 NULL 且非空
+ * @param password AP 密码，可为 NULL/空串 表示开放网络
+ * @param hint     定向提示，可为 NULL
+ */
+esp_err_t wifi_module_connect_with_hint(const char *ssid,
+                                        const char *password,
+                                        const wifi_module_ap_hint_t *hint)
 {
     if (!s_wifi_inited) {
         return ESP_ERR_INVALID_STATE;
@@ -383,6 +675,14 @@ esp_err_t wifi_module_connect(const char *ssid, const char *password)
         sta_cfg.sta.password[sizeof(sta_cfg.sta.password) - 1] = '\0';
     }
 
+    /* 定向提示：锁定 BSSID 与信道，驱动只在该信道探测，跳过全信道扫描 */
+    if (hint != NULL && hint->channel != 0) {
+        sta_cfg.sta.bssid_set          = true;
+        memcpy(sta_cfg.sta.bssid, hint->bssid, sizeof(sta_cfg.sta.bssid));
+        sta_cfg.sta.channel            = hint->channel;
+        sta_cfg.sta.threshold.authmode = hint->authmode;
+    }
+
     esp_err_t   ret;
     wifi_mode_t mode = WIFI_MODE_NULL;
 
@@ -406,6 +706,7 @@ esp_err_t wifi_module_connect(const char *ssid, const char *password)
             ESP_LOGE(TAG, "esp_wifi_set_mode failed: %s", esp_err_to_name(ret));
             return ret;
         }
+        wifi_module_status_set_mode(mode);
     }
 
     /* 设置 STA 配置 */
@@ -416,6 +717,10 @@ esp_err_t wifi_module_connect(const char *ssid, const char *password)
     }
 
     /* 发起连接 */
+    wifi_module_status_write_begin();
+    s_status.timing.connect_start_us = esp_timer_get_time();
+    wifi_module_status_write_end();
+
     s_connecting = true;
     ret          = esp_wifi_connect();
     if (ret != ESP_OK) {
@@ -428,73 +733,161 @@ esp_err_t wifi_module_connect(const char *ssid, const char *password)
 }
 
 /**
- * @brief 同步扫描附近 AP
- *
- * @param results     输出数组，长度由 *count_inout 指定
- * @param count_inout 入参：results 最大容量；出参：实际返回数量
+ * @brief 发起一次异步扫描（立即返回，结果由 SCAN_DONE 事件保存）
  */
-esp_err_t wifi_module_scan(wifi_module_scan_result_t *results, uint16_t *count_inout)
+esp_err_t wifi_module_scan_start(uint32_t *scan_id_out)
 {
-    if (!s_wifi_inited || !s_wifi_cfg.enable_sta ||
-        results == NULL || count_inout == NULL || *count_inout == 0) {
+    if (scan_id_out == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    wifi_scan_config_t scan_cfg = {0};
+    if (!s_wifi_inited || !s_wifi_cfg.enable_sta) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint32_t scan_id;
 
-    ESP_LOGI(TAG, "start wifi scan, max_out=%u", (unsigned)(*count_inout));
+    portENTER_CRITICAL(&s_scan_lock);
+    if (s_scan_running) {
+        portEXIT_CRITICAL(&s_scan_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_scan_running = true;
+    if (++s_scan_id == 0) {
+        s_scan_id = 1;  /* 0 保留为无效编号 */
+    }
+    scan_id = s_scan_id;
+    portEXIT_CRITICAL(&s_scan_lock);
 
-    /* 阻塞式扫描，直到完成 */
-    esp_err_t ret = esp_wifi_scan_start(&scan_cfg, true);
+    ESP_LOGI(TAG, "start wifi scan, id=%u", (unsigned)scan_id);
+
+    wifi_scan_config_t scan_cfg = {0};
+    esp_err_t          ret      = esp_wifi_scan_start(&scan_cfg, false);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "wifi scan start failed: %s", esp_err_to_name(ret));
+        portENTER_CRITICAL(&s_scan_lock);
+        s_scan_running = false;
+        portEXIT_CRITICAL(&s_scan_lock);
         return ret;
     }
 
-    uint16_t ap_num = 0;
-    ret             = esp_wifi_scan_get_ap_num(&ap_num);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "wifi scan get num failed: %s", esp_err_to_name(ret));
-        return ret;
+    *scan_id_out = scan_id;
+    return ESP_OK;
+}
+
+/**
+ * @brief 读取指定扫描编号的结果
+ *
+ * @param scan_id     扫描编号
+ * @param results     输出数组，长度由 *count_inout 指定
+ * @param count_inout 入参：results 最大容量；出参：实际返回数量
+ */
+esp_err_t wifi_module_scan_get_results(uint32_t scan_id,
+                                       wifi_module_scan_result_t *results,
+                                       uint16_t *count_inout)
+{
+    if (results == NULL || count_inout == NULL || *count_inout == 0) {
+        return ESP_ERR_INVALID_ARG;
     }
 
-    if (ap_num == 0) {
-        ESP_LOGI(TAG, "wifi scan done: found 0 AP");
-        *count_inout = 0;
-        return ESP_OK;
+    esp_err_t ret;
+
+    portENTER_CRITICAL(&s_scan_lock);
+    if (scan_id == s_scan_id && s_scan_running) {
+        ret = ESP_ERR_NOT_FINISHED;
+    } else if (scan_id == 0 || scan_id != s_scan_done_id) {
+        ret = ESP_ERR_NOT_FOUND;
+    } else if (s_scan_done_status != ESP_OK) {
+        ret = s_scan_done_status;
+    } else {
+        uint16_t count = (s_scan_count < *count_inout) ? s_scan_count : *count_inout;
+        memcpy(results, s_scan_results, count * sizeof(wifi_module_scan_result_t));
+        *count_inout = count;
+        ret          = ESP_OK;
     }
+    portEXIT_CRITICAL(&s_scan_lock);
 
-    uint16_t max_out = *count_inout;
-    if (max_out == 0) {
+    return ret;
+}
+
+/**
+ * @brief 读取扫描状态概要
+ */
+esp_err_t wifi_module_scan_get_info(wifi_module_scan_info_t *out)
+{
+    if (out == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    if (ap_num > max_out) {
-        ap_num = max_out;
+    portENTER_CRITICAL(&s_scan_lock);
+    out->running      = s_scan_running;
+    out->running_id   = s_scan_id;
+    out->done_id      = s_scan_done_id;
+    out->done_status  = s_scan_done_status;
+    out->done_time_us = s_scan_done_us;
+    portEXIT_CRITICAL(&s_scan_lock);
+
+    return ESP_OK;
+}
+
+/**
+ * @brief 同步扫描附近 AP（发起异步扫描并等待 SCAN_DONE）
+ *
+ * @param results     输出数组，长度由 *count_inout 指定
+ * @param count_inout 入参：results 最大容量；出参：实际返回数量
+ */
+esp_err_t wifi_module_scan(wifi_module_scan_result_t *results, uint16_t *count_inout)
+{
+    if (results == NULL || count_inout == NULL || *count_inout == 0) {
+        return ESP_ERR_INVALID_ARG;
     }
 
-    wifi_ap_record_t *ap_list = calloc(ap_num, sizeof(wifi_ap_record_t));
-    if (ap_list == NULL) {
-        return ESP_ERR_NO_MEM;
+    if (s_scan_done_sem == NULL) {
+        return ESP_ERR_INVALID_STATE;
     }
 
-    ret = esp_wifi_scan_get_ap_records(&ap_num, ap_list);
+    /* 清掉此前遗留的完成信号，只等待本次扫描 */
+    (void)xSemaphoreTake(s_scan_done_sem, 0);
+
+    uint32_t  scan_id = 0;
+    esp_err_t ret     = wifi_module_scan_start(&scan_id);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "wifi scan get records failed: %s", esp_err_to_name(ret));
-        free(ap_list);
         return ret;
     }
 
-    for (uint16_t i = 0; i < ap_num; ++i) {
-        memset(results[i].ssid, 0, sizeof(results[i].ssid));
-        strncpy(results[i].ssid,
-                (const char *)ap_list[i].ssid,
-                sizeof(results[i].ssid) - 1);
-        results[i].rssi = ap_list[i].rssi;
+    while ((ret = wifi_module_scan_get_results(scan_id, results, count_inout)) ==
+           ESP_ERR_NOT_FINISHED) {
+        if (xSemaphoreTake(s_scan_done_sem, pdMS_TO_TICKS(WIFI_MODULE_SCAN_TIMEOUT_MS)) != pdTRUE) {
+            ESP_LOGE(TAG, "wifi scan timeout, id=%u", (unsigned)scan_id);
+            return ESP_ERR_TIMEOUT;
+        }
     }
 
-    *count_inout = ap_num;
-    ESP_LOGI(TAG, "wifi scan done: found %u AP(s), out=%u", (unsigned)ap_num, (unsigned)(*count_inout));
-    free(ap_list);
+    return ret;
+}
+
+/**
+ * @brief 读取 STA 状态快照（顺序锁读侧，无锁、不访问驱动）
+ */
+esp_err_t wifi_module_get_status(wifi_module_status_t *out)
+{
+    if (out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t seq_begin;
+    uint32_t seq_end = 0;
+
+    do {
+        seq_begin = __atomic_load_n(&s_status_seq, __ATOMIC_ACQUIRE);
+        if (seq_begin & 1U) {
+            /* 写入进行中，稍后重试 */
+            continue;
+        }
+        memcpy(out, &s_status, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        seq_end = __atomic_load_n(&s_status_seq, __ATOMIC_RELAXED);
+    } while ((seq_begin & 1U) || seq_begin != seq_end);
+
     return ESP_OK;
 }
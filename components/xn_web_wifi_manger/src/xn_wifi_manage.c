@@ -14,14 +14,19 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/timers.h"
+#include "freertos/semphr.h"
 
 #include "esp_wifi.h"
-#include "esp_netif.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
 
 #include "wifi_module.h"
 #include "storage_module.h"
 #include "web_module.h"
+#include "wifi_metrics.h"
 #include "xn_wifi_manage.h"
 
 /* 日志 TAG（如需日志输出，使用 ESP_LOGx(TAG, ...)） */
@@ -34,7 +39,7 @@ static wifi_manage_config_t s_wifi_cfg;
 /* WiFi 管理任务句柄 */
 static TaskHandle_t         s_wifi_manage_task  = NULL;
 
-/* 统一更新状态并通知上层回调（若配置了 wifi_event_cb） */
+/* 统一更新状态并通知上层回调（若配置了 wifi_event_cb），同时推送给网页订阅者 */
 static void wifi_manage_notify_state(wifi_manage_state_t new_state)
 {
     s_wifi_manage_state = new_state;
@@ -42,12 +47,348 @@ static void wifi_manage_notify_state(wifi_manage_state_t new_state)
     if (s_wifi_cfg.wifi_event_cb) {
         s_wifi_cfg.wifi_event_cb(new_state);
     }
+
+    (void)web_module_notify_status();
 }
 
 /* 遍历已保存 WiFi 时的状态 */
 static bool       s_wifi_connecting   = false;  /* 当前是否有一次 STA 连接正在进行 */
 static uint8_t    s_wifi_try_index    = 0;      /* 本轮遍历中，正在尝试的 WiFi 下标 */
-static TickType_t s_connect_failed_ts = 0;      /* 最近一次全轮尝试失败的时间戳 */
+static bool       s_wifi_try_hinted   = false;  /* 当前连接是否使用了 BSSID / 信道定向提示 */
+static bool       s_wifi_hint_failed  = false;  /* 当前下标的定向连接已失败，改用普通连接 */
+static uint8_t    s_wifi_try_retries  = 0;      /* 当前候选因临时性故障已原地重试的次数 */
+static wifi_config_t s_wifi_try_cfg;             /* 当前候选的已保存配置（按需从存储模块读取，不占任务栈） */
+static bool       s_wifi_manual       = false;  /* 当前连接由网页表单发起，不属于自动轮询 */
+static bool       s_wifi_preempting   = false;  /* 为执行网页连接请求已主动断开，等待断开完成 */
+static char       s_wifi_attempt_ssid[33];      /* 当前连接尝试的 SSID（统计用） */
+static char       s_wifi_link_ssid[33];         /* 当前已连接的 SSID（统计用） */
+static int64_t    s_wifi_lost_us      = 0;      /* 已连接状态下掉线的时间，0 表示没有待恢复的掉线 */
+
+/* -------------------- 选网：扫描后排序的候选列表 -------------------- */
+
+/*
+ * 每轮连接开始前先做一次扫描（近期已有新鲜的扫描结果时直接复用），
+ * 只把扫描中可见的已保存网络作为候选，并按“信号 + 历史”打分从高到低尝试：
+ * - 信号：该 SSID 下最强 AP 的 RSSI（dBm）；
+ * - 历史（各项权重见 wifi_manage_config_t 的 rank_* 字段，单位均为 dB）：
+ *   - 位置：已保存列表按最近成功连接排序，越靠前加分越多（只有前 WIFI_MANAGE_RANK_HISTORY_SPAN 位加分，
+ *     保存数量很多时不会压过信号强度）；
+ *   - 成功率：成功次数 / (成功 + 失败次数)，长期稳定的网络不会被只连过一次的网络挤到后面；
+ *   - 经验：成功次数，满 WIFI_MANAGE_RANK_EXPERIENCE_CAP 次得满分；
+ *   - 耗时：平均获取 IP 耗时越长扣分越多（最多按 WIFI_MANAGE_RANK_IP_TIME_CAP_S 秒计）。
+ * 候选从扫描结果出发，经存储模块的 SSID 哈希索引判断是否已保存，与已保存数量无关。
+ * 候选同时记下最强 AP 的 BSSID / 信道，直接定向连接。
+ *
+ * 扫描失败或没有任何已保存网络可见时（如隐藏 SSID），退回已保存列表的前 s_wifi_list_cap 个，
+ * 按历史得分逐个尝试。
+ */
+#define WIFI_MANAGE_RANK_HISTORY_SPAN    8      /* 参与位置加分的已保存列表前几位 */
+#define WIFI_MANAGE_RANK_EXPERIENCE_CAP  16     /* 经验加分封顶的成功次数 */
+#define WIFI_MANAGE_RANK_IP_TIME_CAP_S   30     /* 耗时扣分封顶的秒数 */
+#define WIFI_MANAGE_SELECT_SCAN_TIMEOUT_MS 10000 /* 等待选网扫描完成的最长时间 */
+
+typedef struct {
+    char                  ssid[33];   /* 候选 SSID（已保存配置中的 32 字节 + '\0'） */
+    int16_t               score;      /* 排序得分，越大越优先 */
+    bool                  has_hint;   /* 扫描中可见，hint 为最强 AP 的定向信息 */
+    wifi_module_ap_hint_t hint;
+} wifi_manage_candidate_t;
+
+static wifi_manage_candidate_t *s_wifi_candidates     = NULL;   /* 容量为 s_wifi_list_cap */
+static uint8_t                  s_wifi_candidate_num  = 0;
+static bool                     s_wifi_round_ready    = false;  /* 本轮候选已生成 */
+static uint32_t                 s_wifi_select_scan_id = 0;      /* 正在等待的选网扫描编号，0 表示无 */
+static bool                     s_wifi_skip_select    = false;  /* 选网扫描超时，本轮不再排序 */
+static bool                     s_wifi_pin_first      = false;  /* 网页指定连接：首选条目固定排在最前 */
+
+/* -------------------- 按 SSID 的失败退避 -------------------- */
+
+/*
+ * 每个网络单独记录连续失败次数，失败后在一段时间内不再作为候选：
+ *   delay = min(reconnect_interval_ms * 2^(fails-1), reconnect_max_interval_ms)
+ * 实际等待在 [delay/2, delay] 内随机取值，避免大量设备在断电恢复后同时冲击同一个 AP。
+ * 连接成功后清零。持续失败的网络因此不会挤占其它恢复中的网络，
+ * 整轮结束后的重试时间也由最早到期的网络决定。
+ */
+#define WIFI_MANAGE_BACKOFF_MAX_SHIFT 16   /* 指数上限，防止移位溢出 */
+
+/*
+ * 等待时长的内部上限（1 小时）：未设置 reconnect_max_interval_ms 或设置过大时生效。
+ * pdMS_TO_TICKS 以 32 位 TickType_t 计算 ms * configTICK_RATE_HZ，1 kHz 时约 71 分钟即溢出，
+ * 定时器周期会变成任意值。
+ */
+#define WIFI_MANAGE_BACKOFF_HARD_MAX_MS 3600000
+
+typedef struct {
+    char    ssid[33];      /* 网络 SSID */
+    uint8_t fail_count;    /* 连续失败次数，0 表示空闲槽位 */
+    int64_t next_try_us;   /* 早于该时间不再尝试（esp_timer 时基） */
+} wifi_manage_backoff_t;
+
+static wifi_manage_backoff_t *s_wifi_backoff     = NULL;  /* 容量为 s_wifi_list_cap，满时复用最早到期的记录 */
+static uint8_t                s_wifi_list_cap    = 1;     /* 候选 / 退避表容量：save_wifi_count 与单次扫描结果上限中的较小值 */
+
+/* -------------------- 管理任务消息 -------------------- */
+
+/*
+ * 管理任务是 WiFi 状态与驱动操作的唯一持有者，平时阻塞在 s_wifi_manage_queue 上，不做任何周期唤醒：
+ * - WiFi 模块事件由 wifi_manage_on_wifi_event 投递，任务中立即推进状态机；
+ * - 整轮失败后的重连等待由一次性软件定时器 s_reconnect_timer 计时，到期后投递 RETRY；
+ * - 网页端的连接 / 删除 / 扫描 / 导入均以命令形式投递，由任务串行执行，HTTP 处理函数不直接操作驱动。
+ *   连接请求只保留最新一次（见 s_user_conn），连续点击会合并；
+ *   删除、扫描与导入需要结果，调用方阻塞等待任务回复（任务本身从不等待 Web 模块，不会死锁）。
+ */
+typedef enum {
+    WIFI_MANAGE_MSG_WIFI_EVENT = 0,  /* 来自 wifi_module 的事件，见 event 字段 */
+    WIFI_MANAGE_MSG_RETRY,           /* 重新开始一轮连接尝试（启动、重连定时到期） */
+    WIFI_MANAGE_MSG_DEADLINE,        /* 本次连接尝试的当前阶段超时，reason 字段为尝试编号 */
+    WIFI_MANAGE_MSG_CMD_CONNECT,     /* 网页连接请求，内容见 s_user_conn */
+    WIFI_MANAGE_MSG_CMD_DELETE,      /* 删除已保存 WiFi（同步，ssid 字段） */
+    WIFI_MANAGE_MSG_CMD_SCAN,        /* 网页发起扫描（同步，value 为 max_age_ms） */
+    WIFI_MANAGE_MSG_FLUSH,           /* 将存储模块暂存的连接统计写入 NVS */
+    WIFI_MANAGE_MSG_CMD_IMPORT,      /* 批量导入已保存 WiFi（同步，arg 指向 wifi_manage_import_t） */
+} wifi_manage_msg_type_t;
+
+typedef struct {
+    wifi_manage_msg_type_t type;
+    wifi_module_event_t    event;
+    uint16_t               reason;   /* 断开原因（wifi_err_reason_t），仅断开 / 连接失败事件有效 */
+    uint32_t               value;    /* 命令参数 */
+    char                   ssid[33]; /* 命令参数 */
+    const void            *arg;      /* 命令参数（同步命令，调用方等待期间有效） */
+} wifi_manage_msg_t;
+
+/* WIFI_MANAGE_MSG_CMD_IMPORT 的参数 */
+typedef struct {
+    const wifi_config_t *configs;
+    uint16_t             count;
+    bool                 replace;
+} wifi_manage_import_t;
+
+#define WIFI_MANAGE_QUEUE_LEN          16
+#define WIFI_MANAGE_CALL_POST_TIMEOUT_MS 1000   /* 同步命令入队的最长等待 */
+
+static QueueHandle_t s_wifi_manage_queue = NULL;
+static TimerHandle_t s_reconnect_timer   = NULL;
+static TimerHandle_t s_flush_timer       = NULL;   /* 连接统计延迟写入 */
+static bool          s_flush_scheduled   = false;  /* s_flush_timer 已启动且尚未到期 */
+
+/* 同步命令：调用方持有 s_call_lock 期间投递命令，任务写回结果后释放 s_call_done */
+static SemaphoreHandle_t s_call_lock  = NULL;
+static SemaphoreHandle_t s_call_done  = NULL;
+static esp_err_t         s_call_ret   = ESP_OK;
+static uint32_t          s_call_value = 0;
+
+/* 待执行的网页连接请求（只保留最新一次） */
+static portMUX_TYPE s_user_conn_lock = portMUX_INITIALIZER_UNLOCKED;
+static struct {
+    bool pending;
+    bool saved;          /* true：连接已保存条目；false：表单连接 */
+    char ssid[33];
+    char password[65];
+} s_user_conn;
+
+/* -------------------- 单次连接尝试的阶段截止时间 -------------------- */
+
+/*
+ * 每次连接尝试分两个阶段计时：关联（发起连接 → STA_CONNECTED）与 DHCP（→ GOT_IP），
+ * 分别受 assoc_timeout_ms / dhcp_timeout_ms 限制。超时后主动断开，
+ * 随后的断开事件按本候选失败处理并切换到下一个；断开后 WIFI_MANAGE_ABORT_GRACE_MS
+ * 内仍无事件则直接放弃本次尝试，避免 DHCP 服务异常等情况让故障切换无限期停滞。
+ */
+#define WIFI_MANAGE_ABORT_GRACE_MS 2000
+
+typedef enum {
+    WIFI_MANAGE_PHASE_NONE = 0,   /* 没有进行中的连接尝试 */
+    WIFI_MANAGE_PHASE_ASSOC,      /* 等待与 AP 建立链路 */
+    WIFI_MANAGE_PHASE_DHCP,       /* 已关联，等待获取 IP */
+    WIFI_MANAGE_PHASE_ABORT,      /* 已超时并主动断开，等待断开事件 */
+} wifi_manage_phase_t;
+
+static TimerHandle_t       s_attempt_timer    = NULL;
+static wifi_manage_phase_t s_wifi_phase       = WIFI_MANAGE_PHASE_NONE;
+static uint16_t            s_wifi_attempt_gen = 0;   /* 尝试编号，用于丢弃过期的超时消息 */
+
+/**
+ * @brief 向管理任务投递一条消息（任意任务 / 定时器上下文，不阻塞）
+ */
+static void wifi_manage_post(wifi_manage_msg_type_t type, wifi_module_event_t event, uint16_t reason)
+{
+    if (s_wifi_manage_queue == NULL) {
+        return;
+    }
+
+    wifi_manage_msg_t msg = {
+        .type   = type,
+        .event  = event,
+        .reason = reason,
+    };
+    if (xQueueSend(s_wifi_manage_queue, &msg, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "manage queue full, drop msg type=%d", (int)type);
+    }
+}
+
+/**
+ * @brief 同步执行一条命令：投递后等待管理任务回复（仅限管理任务以外的任务调用）
+ *
+ * @param[in]     arg   命令参数（指针），在等待期间保持有效即可
+ * @param[in,out] value 命令参数，返回时为命令结果值（可为 NULL）
+ */
+static esp_err_t wifi_manage_call(wifi_manage_msg_type_t type, const char *ssid, const void *arg, uint32_t *value)
+{
+    if (s_wifi_manage_queue == NULL || s_call_lock == NULL || s_call_done == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    wifi_manage_msg_t msg = {
+        .type  = type,
+        .value = (value != NULL) ? *value : 0,
+        .arg   = arg,
+    };
+    if (ssid != NULL) {
+        strncpy(msg.ssid, ssid, sizeof(msg.ssid) - 1);
+    }
+
+    (void)xSemaphoreTake(s_call_lock, portMAX_DELAY);
+
+    esp_err_t ret;
+    if (xQueueSend(s_wifi_manage_queue, &msg, pdMS_TO_TICKS(WIFI_MANAGE_CALL_POST_TIMEOUT_MS)) != pdTRUE) {
+        ret = ESP_ERR_TIMEOUT;
+    } else {
+        (void)xSemaphoreTake(s_call_done, portMAX_DELAY);
+        ret = s_call_ret;
+        if (value != NULL) {
+            *value = s_call_value;
+        }
+    }
+
+    (void)xSemaphoreGive(s_call_lock);
+    return ret;
+}
+
+/**
+ * @brief 管理任务回复同步命令
+ */
+static void wifi_manage_call_reply(esp_err_t ret, uint32_t value)
+{
+    s_call_ret   = ret;
+    s_call_value = value;
+    (void)xSemaphoreGive(s_call_done);
+}
+
+/**
+ * @brief 提交一次网页连接请求，覆盖尚未执行的旧请求
+ */
+static void wifi_manage_submit_connect(bool saved, const char *ssid, const char *password)
+{
+    bool was_pending;
+
+    portENTER_CRITICAL(&s_user_conn_lock);
+    was_pending       = s_user_conn.pending;
+    s_user_conn.saved = saved;
+    strncpy(s_user_conn.ssid, ssid, sizeof(s_user_conn.ssid) - 1);
+    s_user_conn.ssid[sizeof(s_user_conn.ssid) - 1] = '\0';
+    s_user_conn.password[0] = '\0';
+    if (password != NULL) {
+        strncpy(s_user_conn.password, password, sizeof(s_user_conn.password) - 1);
+        s_user_conn.password[sizeof(s_user_conn.password) - 1] = '\0';
+    }
+    s_user_conn.pending = true;
+    portEXIT_CRITICAL(&s_user_conn_lock);
+
+    if (!was_pending) {
+        wifi_manage_post(WIFI_MANAGE_MSG_CMD_CONNECT, 0, 0);
+    }
+}
+
+/**
+ * @brief 重连定时器回调（定时器服务任务上下文）
+ */
+static void wifi_manage_reconnect_timer_cb(TimerHandle_t timer)
+{
+    (void)timer;
+    wifi_manage_post(WIFI_MANAGE_MSG_RETRY, 0, 0);
+}
+
+/**
+ * @brief 统计写入定时器回调（定时器服务任务上下文）
+ */
+static void wifi_manage_flush_timer_cb(TimerHandle_t timer)
+{
+    (void)timer;
+    wifi_manage_post(WIFI_MANAGE_MSG_FLUSH, 0, 0);
+}
+
+/**
+ * @brief 存储模块有暂存的连接统计时，安排一次延迟写入
+ *
+ * 延迟期内的多次重连合并为一次 NVS 提交；storage_flush_delay_ms <= 0 时立即写入。
+ */
+static void wifi_manage_schedule_flush(void)
+{
+    if (!wifi_storage_has_pending() || s_flush_scheduled) {
+        return;
+    }
+    if (s_wifi_cfg.storage_flush_delay_ms <= 0 || s_flush_timer == NULL) {
+        (void)wifi_storage_flush();
+        return;
+    }
+    s_flush_scheduled = true;
+    (void)xTimerChangePeriod(s_flush_timer, pdMS_TO_TICKS(s_wifi_cfg.storage_flush_delay_ms), 0);
+}
+
+/**
+ * @brief 阶段截止定时器回调（定时器服务任务上下文），定时器 ID 中保存启动时的尝试编号
+ */
+static void wifi_manage_attempt_timer_cb(TimerHandle_t timer)
+{
+    uint16_t gen = (uint16_t)(uintptr_t)pvTimerGetTimerID(timer);
+    wifi_manage_post(WIFI_MANAGE_MSG_DEADLINE, 0, gen);
+}
+
+/**
+ * @brief 进入连接尝试的某个阶段，并按该阶段的时限重新计时
+ *
+ * @param timeout_ms <=0 表示该阶段不限时
+ */
+static void wifi_manage_phase_enter(wifi_manage_phase_t phase, int timeout_ms)
+{
+    s_wifi_phase = phase;
+
+    if (s_attempt_timer == NULL) {
+        return;
+    }
+    if (phase == WIFI_MANAGE_PHASE_NONE || timeout_ms <= 0) {
+        (void)xTimerStop(s_attempt_timer, 0);
+        return;
+    }
+
+    TickType_t period = pdMS_TO_TICKS(timeout_ms);
+    if (period == 0) {
+        period = 1;
+    }
+    vTimerSetTimerID(s_attempt_timer, (void *)(uintptr_t)s_wifi_attempt_gen);
+    (void)xTimerChangePeriod(s_attempt_timer, period, 0);
+}
+
+/**
+ * @brief 结束当前一轮尝试，下次从选网重新开始
+ */
+static void wifi_manage_reset_round(void)
+{
+    s_wifi_try_index      = 0;
+    s_wifi_try_hinted     = false;
+    s_wifi_hint_failed    = false;
+    s_wifi_try_retries    = 0;
+    s_wifi_round_ready    = false;
+    s_wifi_select_scan_id = 0;
+    s_wifi_skip_select    = false;
+
+    /* 停止可能仍在计时的选网扫描超时，避免其 RETRY 干扰下一轮 */
+    if (s_reconnect_timer != NULL) {
+        (void)xTimerStop(s_reconnect_timer, 0);
+    }
+}
 
 /* -------------------- Web 回调：查询当前 WiFi 状态 -------------------- */
 /**
@@ -58,6 +399,8 @@ static TickType_t s_connect_failed_ts = 0;      /* 最近一次全轮尝试失
  * - 当前 SSID；
  * - 当前 IPv4 地址；
  * - 当前 RSSI。
+ *
+ * 连接详情读取自 wifi_module_get_status() 快照，常数时间完成，不调用驱动 / netif 接口。
  */
 static esp_err_t wifi_manage_get_web_status(web_wifi_status_t *out)
 {
@@ -90,312 +433,963 @@ static esp_err_t wifi_manage_get_web_status(web_wifi_status_t *out)
             out->state = WEB_WIFI_STATUS_STATE_FAILED;
             break;
 
-        case WIFI_MANAGE_STATE_DISCONNECTED:
-        default:
-            out->state = WEB_WIFI_STATUS_STATE_IDLE;
-            break;
+        case WIFI_MANAGE_STATE_DISCONNECTED:
+        default:
+            out->state = WEB_WIFI_STATUS_STATE_IDLE;
+            break;
+        }
+    }
+
+    /* 非“已连接”状态下不再继续读取底层信息 */
+    if (out->state != WEB_WIFI_STATUS_STATE_CONNECTED) {
+        return ESP_OK;
+    }
+
+    /* SSID / IP / RSSI / 模式均来自 WiFi 模块维护的状态快照，不访问驱动 */
+    wifi_module_status_t snapshot;
+    (void)wifi_module_get_status(&snapshot);
+
+    if (snapshot.ssid[0] != '\0') {
+        strncpy(out->ssid, snapshot.ssid, sizeof(out->ssid));
+        out->ssid[sizeof(out->ssid) - 1] = '\0';
+    }
+    if (snapshot.ip[0] != '\0') {
+        memcpy(out->ip, snapshot.ip, sizeof(out->ip));
+    }
+    out->rssi = snapshot.rssi;
+
+    /* 将当前 WiFi 模式转换为简短字符串 */
+    const char *mode_str = "-";
+
+    switch (snapshot.mode) {
+    case WIFI_MODE_STA:
+        mode_str = "STA";
+        break;
+    case WIFI_MODE_AP:
+        mode_str = "AP";
+        break;
+    case WIFI_MODE_APSTA:
+        mode_str = "AP+STA";
+        break;
+    default:
+        break;
+    }
+
+    strncpy(out->mode, mode_str, sizeof(out->mode));
+    out->mode[sizeof(out->mode) - 1] = '\0';
+
+    return ESP_OK;
+}
+
+/* -------------------- Web 回调：已保存 WiFi 列表与删除 -------------------- */
+/**
+ * @brief 提供给 Web 的“遍历已保存 WiFi 列表”回调
+ *
+ * 只需要 SSID 与统计：直接从存储模块的内存索引按位置逐条读取，不读取 Flash 中的记录，
+ * 也不需要任何缓冲数组。
+ */
+static esp_err_t wifi_manage_foreach_web_saved(web_saved_visit_fn_t visit, void *ctx)
+{
+    if (visit == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    web_saved_wifi_info_t info;
+    for (uint16_t i = 0; wifi_storage_get_ssid_at(i, info.ssid, sizeof(info.ssid)) == ESP_OK; i++) {
+        wifi_storage_stats_t st = {0};
+        (void)wifi_storage_get_stats(info.ssid, &st);
+        info.success_count = st.success_count;
+        info.fail_count    = st.fail_count;
+        info.last_success  = st.last_success;
+        info.time_to_ip_ms = st.time_to_ip_ms;
+
+        esp_err_t ret = visit(ctx, &info);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 提供给 Web 的“删除已保存 WiFi”回调
+ */
+static esp_err_t wifi_manage_delete_web_saved(const char *ssid)
+{
+    if (ssid == NULL || ssid[0] == '\0') {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return wifi_manage_call(WIFI_MANAGE_MSG_CMD_DELETE, ssid, NULL, NULL);
+}
+
+/* -------------------- 批量导入 / 导出 -------------------- */
+/**
+ * @brief 批量导入已保存 WiFi（不连接），交由管理任务执行
+ */
+esp_err_t wifi_manage_import_saved(const wifi_config_t *configs, uint16_t count, bool replace)
+{
+    const wifi_manage_import_t imp = {
+        .configs = configs,
+        .count   = count,
+        .replace = replace,
+    };
+    return wifi_manage_call(WIFI_MANAGE_MSG_CMD_IMPORT, NULL, &imp, NULL);
+}
+
+/**
+ * @brief 提供给 Web 的“批量导入”回调：转换为 wifi_config_t 后导入
+ */
+/* 导出的完整列表必须能原样导入 */
+_Static_assert(WEB_SAVED_IMPORT_MAX_ITEMS >= WIFI_STORAGE_MAX_NUM, "web import limit below storage limit");
+
+static esp_err_t wifi_manage_import_web_saved(const web_saved_import_item_t *items, size_t count, bool replace)
+{
+    if (count > WIFI_STORAGE_MAX_NUM) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    wifi_config_t *configs = NULL;
+    if (count > 0) {
+        configs = (wifi_config_t *)calloc(count, sizeof(wifi_config_t));
+        if (configs == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        memcpy(configs[i].sta.ssid, items[i].ssid, strnlen(items[i].ssid, sizeof(configs[i].sta.ssid)));
+        memcpy(configs[i].sta.password, items[i].password,
+               strnlen(items[i].password, sizeof(configs[i].sta.password)));
+    }
+
+    esp_err_t ret = wifi_manage_import_saved(configs, (uint16_t)count, replace);
+    free(configs);
+    return ret;
+}
+
+typedef struct {
+    web_saved_emit_fn_t emit;
+    void               *ctx;
+    esp_err_t           ret;
+} wifi_manage_export_ctx_t;
+
+static bool wifi_manage_export_visit(const wifi_config_t *config, void *ctx)
+{
+    wifi_manage_export_ctx_t *ex = (wifi_manage_export_ctx_t *)ctx;
+    char ssid[33]     = {0};
+    char password[65] = {0};
+
+    memcpy(ssid, config->sta.ssid, sizeof(config->sta.ssid));
+    memcpy(password, config->sta.password, sizeof(config->sta.password));
+    ex->ret = ex->emit(ex->ctx, ssid, password);
+    return ex->ret == ESP_OK;
+}
+
+/**
+ * @brief 提供给 Web 的“导出”回调：按优先级逐条读取并输出
+ */
+static esp_err_t wifi_manage_export_web_saved(web_saved_emit_fn_t emit, void *ctx)
+{
+    wifi_manage_export_ctx_t ex = {
+        .emit = emit,
+        .ctx  = ctx,
+        .ret  = ESP_OK,
+    };
+    esp_err_t ret = wifi_storage_foreach(wifi_manage_export_visit, &ex);
+    return (ret != ESP_OK) ? ret : ex.ret;
+}
+
+/* -------------------- Web 回调：扫描附近 WiFi -------------------- */
+/**
+ * @brief 执行网页扫描命令（管理任务上下文）
+ *
+ * 直接使用 wifi_module 的异步扫描编号作为任务编号，按以下顺序决定返回哪个任务：
+ * 1. 最近一次扫描成功且年龄不超过 max_age_ms（缺省为 scan_cache_ttl_ms）时直接复用；
+ * 2. 已有扫描进行中时合并到该扫描，不再占用射频；
+ * 3. 否则发起新的扫描。
+ *
+ * 结果本身保存在 wifi_module 中（所有扫描都经由此处发起，已完成的结果不会被意外覆盖），
+ * 这里只负责缓存 / 合并策略。APSTA 模式下扫描会同时影响 STA 上行与配网热点，
+ * 因此尽量减少实际扫描次数。
+ */
+static esp_err_t wifi_manage_do_scan_start(uint32_t max_age_ms, uint32_t *job_id)
+{
+    if (max_age_ms == WEB_SCAN_MAX_AGE_DEFAULT) {
+        max_age_ms = (s_wifi_cfg.scan_cache_ttl_ms > 0) ? (uint32_t)s_wifi_cfg.scan_cache_ttl_ms : 0;
+    }
+
+    wifi_module_scan_info_t info;
+    (void)wifi_module_scan_get_info(&info);
+
+    /* 1. 缓存命中 */
+    if (max_age_ms > 0 && !info.running && info.done_id != 0 && info.done_status == ESP_OK) {
+        int64_t age_ms = (esp_timer_get_time() - info.done_time_us) / 1000;
+        if (age_ms <= (int64_t)max_age_ms) {
+            ESP_LOGD(TAG, "scan cache hit: job=%u age=%lldms", (unsigned)info.done_id, (long long)age_ms);
+            *job_id = info.done_id;
+            return ESP_OK;
+        }
+    }
+
+    /* 2. 合并到进行中的扫描 */
+    if (info.running) {
+        ESP_LOGD(TAG, "scan coalesced: job=%u", (unsigned)info.running_id);
+        *job_id = info.running_id;
+        return ESP_OK;
+    }
+
+    /* 3. 发起新扫描；若恰好有扫描在读取状态后启动，则同样合并过去 */
+    esp_err_t ret = wifi_module_scan_start(job_id);
+    if (ret == ESP_ERR_INVALID_STATE &&
+        wifi_module_scan_get_info(&info) == ESP_OK && info.running) {
+        *job_id = info.running_id;
+        return ESP_OK;
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "web scan start failed: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/**
+ * @brief 提供给 Web 的“发起扫描”回调：交由管理任务执行并等待任务编号
+ */
+static esp_err_t wifi_manage_scan_start_web(uint32_t max_age_ms, uint32_t *job_id)
+{
+    if (job_id == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t  value = max_age_ms;
+    esp_err_t ret   = wifi_manage_call(WIFI_MANAGE_MSG_CMD_SCAN, NULL, NULL, &value);
+    if (ret == ESP_OK) {
+        *job_id = value;
+    }
+    return ret;
+}
+
+/**
+ * @brief 提供给 Web 的“查询扫描结果”回调
+ *
+ * 按任务编号从 wifi_module 读取结果，并转换为 Web 端展示所需的精简字段。
+ */
+static esp_err_t wifi_manage_scan_result_web(uint32_t job_id, web_scan_result_t *list, size_t *inout_cnt)
+{
+    if (list == NULL || inout_cnt == NULL || *inout_cnt == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint16_t cap = (*inout_cnt > WIFI_MODULE_SCAN_MAX_RESULTS)
+                       ? WIFI_MODULE_SCAN_MAX_RESULTS
+                       : (uint16_t)(*inout_cnt);
+    wifi_module_scan_result_t *results =
+        (wifi_module_scan_result_t *)malloc(cap * sizeof(wifi_module_scan_result_t));
+    if (results == NULL) {
+        *inout_cnt = 0;
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint16_t  count = cap;
+    esp_err_t ret   = wifi_module_scan_get_results(job_id, results, &count);
+    if (ret != ESP_OK) {
+        free(results);
+        *inout_cnt = 0;
+        return ret;
+    }
+
+    for (uint16_t i = 0; i < count; i++) {
+        strncpy(list[i].ssid, results[i].ssid, sizeof(list[i].ssid));
+        list[i].ssid[sizeof(list[i].ssid) - 1] = '\0';
+        list[i].rssi = results[i].rssi;
+    }
+
+    free(results);
+    *inout_cnt = count;
+    return ESP_OK;
+}
+
+/* -------------------- Web 回调：从已保存列表触发连接 -------------------- */
+/**
+ * @brief 提供给 Web 的“连接已保存 WiFi”回调
+ *
+ * 仅确认该 SSID 已保存后提交连接请求即返回，实际动作由管理任务执行：
+ * 将其提升为最高优先级，断开当前连接后重新选网（该条目固定最先尝试）。
+ */
+static esp_err_t wifi_manage_connect_web_saved(const char *ssid)
+{
+    if (ssid == NULL || ssid[0] == '\0') {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = wifi_storage_find(ssid, NULL);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    wifi_manage_submit_connect(true, ssid, NULL);
+    return ESP_OK;
+}
+
+/* -------------------- Web 回调：表单连接 WiFi -------------------- */
+/**
+ * @brief 提供给 Web 的“表单连接 WiFi”回调
+ *
+ * 提交连接请求后立即返回，由管理任务断开当前连接并发起一次手动连接；
+ * 连接成功后按常规流程保存，失败则恢复自动选网。
+ */
+static esp_err_t wifi_manage_connect_web_form(const char *ssid, const char *password)
+{
+    if (ssid == NULL || ssid[0] == '\0') {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const char *pwd = (password != NULL && password[0] != '\0') ? password : NULL;
+
+    wifi_manage_submit_connect(false, ssid, pwd);
+    return ESP_OK;
+}
+
+/* -------------------- 失败退避 -------------------- */
+/**
+ * @brief 查找某个 SSID 的退避记录
+ *
+ * @param create 不存在时是否分配槽位（优先空闲槽位，否则复用最早到期的记录）
+ */
+static wifi_manage_backoff_t *wifi_manage_backoff_find(const char *ssid, bool create)
+{
+    wifi_manage_backoff_t *victim = NULL;
+
+    for (uint8_t i = 0; s_wifi_backoff != NULL && i < s_wifi_list_cap; i++) {
+        wifi_manage_backoff_t *b = &s_wifi_backoff[i];
+        if (b->fail_count != 0 && strcmp(b->ssid, ssid) == 0) {
+            return b;
+        }
+        if (b->fail_count == 0) {
+            if (victim == NULL || victim->fail_count != 0) {
+                victim = b;
+            }
+        } else if (victim == NULL ||
+                   (victim->fail_count != 0 && b->next_try_us < victim->next_try_us)) {
+            victim = b;
+        }
+    }
+
+    if (!create || victim == NULL) {
+        return NULL;
+    }
+    memset(victim, 0, sizeof(*victim));
+    strncpy(victim->ssid, ssid, sizeof(victim->ssid) - 1);
+    return victim;
+}
+
+/**
+ * @brief 记录一次连接失败并计算下次允许尝试的时间
+ *
+ * @param demote 为 true 时直接按上限退避（如密码错误，重试也不会成功，等待用户在网页上重新指定）
+ */
+static void wifi_manage_backoff_on_fail(const char *ssid, bool demote)
+{
+    if (s_wifi_cfg.reconnect_interval_ms < 0) {
+        return;   /* 已关闭自动重连，不做退避 */
+    }
+
+    wifi_manage_backoff_t *b = wifi_manage_backoff_find(ssid, true);
+    if (b == NULL) {
+        return;
+    }
+    if (b->fail_count < UINT8_MAX) {
+        b->fail_count++;
+    }
+
+    uint8_t shift = b->fail_count - 1;
+    if (shift > WIFI_MANAGE_BACKOFF_MAX_SHIFT) {
+        shift = WIFI_MANAGE_BACKOFF_MAX_SHIFT;
+    }
+    int64_t delay_ms = (int64_t)s_wifi_cfg.reconnect_interval_ms << shift;
+    if (demote) {
+        shift    = WIFI_MANAGE_BACKOFF_MAX_SHIFT;
+        delay_ms = (int64_t)s_wifi_cfg.reconnect_interval_ms << shift;
+    }
+    if (s_wifi_cfg.reconnect_max_interval_ms > 0 && delay_ms > s_wifi_cfg.reconnect_max_interval_ms) {
+        delay_ms = s_wifi_cfg.reconnect_max_interval_ms;
+    }
+    if (delay_ms > WIFI_MANAGE_BACKOFF_HARD_MAX_MS) {
+        delay_ms = WIFI_MANAGE_BACKOFF_HARD_MAX_MS;
+    }
+
+    /* 抖动：在 [delay/2, delay] 内均匀取值 */
+    int64_t half = delay_ms / 2;
+    if (half > 0) {
+        delay_ms = half + (int64_t)(esp_random() % (uint32_t)(half + 1));
+    }
+
+    b->next_try_us = esp_timer_get_time() + delay_ms * 1000;
+    ESP_LOGI(TAG, "backoff: \"%s\" fails=%u, next try in %lldms",
+             ssid, (unsigned)b->fail_count, (long long)delay_ms);
+}
+
+/**
+ * @brief 连接成功或用户指定连接时清除退避
+ */
+static void wifi_manage_backoff_clear(const char *ssid)
+{
+    wifi_manage_backoff_t *b = wifi_manage_backoff_find(ssid, false);
+    if (b != NULL) {
+        memset(b, 0, sizeof(*b));
+    }
+}
+
+/**
+ * @brief 某个 SSID 是否仍在退避期内
+ */
+static bool wifi_manage_backoff_active(const char *ssid, int64_t now_us)
+{
+    wifi_manage_backoff_t *b = wifi_manage_backoff_find(ssid, false);
+    return (b != NULL && b->next_try_us > now_us);
+}
+
+/**
+ * @brief 距最早一个退避到期还需多久（ms）；没有处于退避期的网络时返回 -1
+ */
+static int64_t wifi_manage_backoff_next_ms(void)
+{
+    int64_t now_us  = esp_timer_get_time();
+    int64_t best_us = -1;
+
+    for (uint8_t i = 0; s_wifi_backoff != NULL && i < s_wifi_list_cap; i++) {
+        const wifi_manage_backoff_t *b = &s_wifi_backoff[i];
+        if (b->fail_count == 0 || b->next_try_us <= now_us) {
+            continue;
+        }
+        if (best_us < 0 || b->next_try_us - now_us < best_us) {
+            best_us = b->next_try_us - now_us;
+        }
+    }
+
+    return (best_us < 0) ? -1 : (best_us + 999) / 1000;
+}
+
+/* -------------------- 选网 -------------------- */
+/**
+ * @brief 按得分插入候选（得分相同保持插入顺序），候选表已满时忽略
+ */
+static void wifi_manage_add_candidate(const wifi_manage_candidate_t *cand)
+{
+    if (s_wifi_candidate_num >= s_wifi_list_cap) {
+        return;
+    }
+
+    uint8_t pos = s_wifi_candidate_num;
+    while (pos > 0 && s_wifi_candidates[pos - 1].score < cand->score) {
+        s_wifi_candidates[pos] = s_wifi_candidates[pos - 1];
+        pos--;
+    }
+    s_wifi_candidates[pos] = *cand;
+    s_wifi_candidate_num++;
+}
+
+/**
+ * @brief 按已保存位置与连接统计计算候选的历史得分（dB，不含信号强度）
+ *
+ * @param rank 在已保存列表中的位置（0 为最近成功连接）
+ * @param span 参与位置加分的前几位
+ */
+static int32_t wifi_manage_history_score(const char *ssid, uint16_t rank, uint16_t span)
+{
+    int32_t score = 0;
+    if (rank < span) {
+        score += (int32_t)(span - 1 - rank) * s_wifi_cfg.rank_recency_db;
+    }
+
+    wifi_storage_stats_t st;
+    if (wifi_storage_get_stats(ssid, &st) != ESP_OK) {
+        return score;
+    }
+
+    uint64_t attempts = (uint64_t)st.success_count + st.fail_count;
+    if (attempts > 0) {
+        score += (int32_t)((int64_t)s_wifi_cfg.rank_reliability_db * st.success_count / (int64_t)attempts);
+    }
+
+    uint32_t exp = (st.success_count < WIFI_MANAGE_RANK_EXPERIENCE_CAP) ? st.success_count
+                                                                        : WIFI_MANAGE_RANK_EXPERIENCE_CAP;
+    score += s_wifi_cfg.rank_experience_db * (int32_t)exp / WIFI_MANAGE_RANK_EXPERIENCE_CAP;
+
+    uint32_t ip_ms = (st.time_to_ip_ms < WIFI_MANAGE_RANK_IP_TIME_CAP_S * 1000) ? st.time_to_ip_ms
+                                                                              : WIFI_MANAGE_RANK_IP_TIME_CAP_S * 1000;
+    score -= (int32_t)((int64_t)s_wifi_cfg.rank_ip_time_db * ip_ms / 1000);
+
+    return score;
+}
+
+/**
+ * @brief 将得分限制在 int16 范围内（INT16_MAX 留给网页指定的首选网络）
+ */
+static int16_t wifi_manage_clamp_score(int32_t score)
+{
+    if (score >= INT16_MAX) {
+        return INT16_MAX - 1;
+    }
+    if (score < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)score;
+}
+
+/**
+ * @brief 根据扫描结果生成本轮候选列表
+ *
+ * @param count   已保存网络数量
+ * @param results 扫描结果；为 NULL 表示没有可用扫描，按已保存顺序作为候选
+ */
+static void wifi_manage_build_candidates(uint16_t count,
+                                         const wifi_module_scan_result_t *results, uint16_t result_num)
+{
+    uint16_t span = (count < WIFI_MANAGE_RANK_HISTORY_SPAN) ? count : WIFI_MANAGE_RANK_HISTORY_SPAN;
+
+    s_wifi_candidate_num = 0;
+
+    if (results == NULL) {
+        for (uint16_t i = 0; i < count && s_wifi_candidate_num < s_wifi_list_cap; i++) {
+            wifi_manage_candidate_t cand = {0};
+            if (wifi_storage_get_ssid_at(i, cand.ssid, sizeof(cand.ssid)) != ESP_OK) {
+                break;
+            }
+            cand.score = (i == 0 && s_wifi_pin_first)
+                             ? INT16_MAX
+                             : wifi_manage_clamp_score(wifi_manage_history_score(cand.ssid, i, span));
+            wifi_manage_add_candidate(&cand);
+        }
+        return;
+    }
+
+    for (uint16_t j = 0; j < result_num; j++) {
+        const wifi_module_scan_result_t *ap = &results[j];
+        if (ap->ssid[0] == '\0') {
+            continue;
+        }
+
+        /* 同一 SSID 只取信号最强的 AP（强度相同取先出现的） */
+        bool weaker = false;
+        for (uint16_t k = 0; k < result_num && !weaker; k++) {
+            weaker = (k != j && strcmp(results[k].ssid, ap->ssid) == 0 &&
+                      (results[k].rssi > ap->rssi || (results[k].rssi == ap->rssi && k < j)));
+        }
+        if (weaker) {
+            continue;
+        }
+
+        uint16_t rank = 0;
+        if (wifi_storage_get_index(ap->ssid, &rank) != ESP_OK) {
+            continue;   /* 未保存 */
         }
-    }
 
-    /* 非“已连接”状态下不再继续读取底层信息 */
-    if (out->state != WEB_WIFI_STATUS_STATE_CONNECTED) {
-        return ESP_OK;
+        wifi_manage_candidate_t cand = {0};
+        strncpy(cand.ssid, ap->ssid, sizeof(cand.ssid) - 1);
+        cand.has_hint = true;
+        memcpy(cand.hint.bssid, ap->bssid, sizeof(cand.hint.bssid));
+        cand.hint.channel  = ap->channel;
+        cand.hint.authmode = ap->authmode;
+        cand.score         = (rank == 0 && s_wifi_pin_first)
+                                 ? INT16_MAX
+                                 : wifi_manage_clamp_score(ap->rssi + wifi_manage_history_score(ap->ssid, rank, span));
+
+        wifi_manage_add_candidate(&cand);
     }
+}
 
-    /* 读取当前连接 AP 的基础信息（SSID + RSSI） */
-    wifi_ap_record_t ap_info = {0};
-    if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
-        strncpy(out->ssid, (const char *)ap_info.ssid, sizeof(out->ssid));
-        out->ssid[sizeof(out->ssid) - 1] = '\0';
-        out->rssi = ap_info.rssi;
+/**
+ * @brief 用指定编号的扫描结果完成选网；结果不可用或没有可见的已保存网络时退回按已保存顺序
+ */
+static void wifi_manage_rank_from_scan(uint32_t scan_id)
+{
+    wifi_module_scan_result_t *results = NULL;
+    uint16_t                   num     = 0;
+    uint16_t                   count   = 0;
+
+    (void)wifi_storage_get_count(&count);
+
+    char pinned[33] = {0};
+    if (s_wifi_pin_first && wifi_storage_get_ssid_at(0, pinned, sizeof(pinned)) == ESP_OK) {
+        wifi_manage_backoff_clear(pinned);
     }
 
-    /* 读取当前 STA IPv4 地址（根据默认 netif 关键字获取） */
-    esp_netif_t *sta_netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
-    if (sta_netif != NULL) {
-        esp_netif_ip_info_t ip_info = {0};
-        if (esp_netif_get_ip_info(sta_netif, &ip_info) == ESP_OK) {
-            /* 使用 IPSTR / IP2STR 宏将 IPv4 地址转换为文本 */
-            snprintf(out->ip,
-                     sizeof(out->ip),
-                     IPSTR,
-                     IP2STR(&ip_info.ip));
+    if (scan_id != 0) {
+        results = (wifi_module_scan_result_t *)malloc(WIFI_MODULE_SCAN_MAX_RESULTS *
+                                                      sizeof(wifi_module_scan_result_t));
+    }
+    if (results != NULL) {
+        num = WIFI_MODULE_SCAN_MAX_RESULTS;
+        esp_err_t ret = wifi_module_scan_get_results(scan_id, results, &num);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "select: scan %u unusable (%s)", (unsigned)scan_id, esp_err_to_name(ret));
+            free(results);
+            results = NULL;
         }
     }
 
-    /* 读取当前 WiFi 模式，并转换为简短字符串 */
-    wifi_mode_t wifi_mode = WIFI_MODE_NULL;
-    if (esp_wifi_get_mode(&wifi_mode) == ESP_OK) {
-        const char *mode_str = "-";
+    if (results != NULL) {
+        wifi_manage_build_candidates(count, results, num);
+        free(results);
+    }
+    if (s_wifi_candidate_num == 0) {
+        /* 扫描不可用或已保存网络均不可见（可能为隐藏 SSID），按已保存顺序逐个尝试 */
+        wifi_manage_build_candidates(count, NULL, 0);
+        ESP_LOGI(TAG, "select: no saved network visible, trying %u in saved order",
+                 (unsigned)s_wifi_candidate_num);
+    } else {
+        ESP_LOGI(TAG, "select: %u of %u saved visible, best \"%s\" score=%d",
+                 (unsigned)s_wifi_candidate_num, (unsigned)count,
+                 s_wifi_candidates[0].ssid, (int)s_wifi_candidates[0].score);
+    }
 
-        switch (wifi_mode) {
-        case WIFI_MODE_STA:
-            mode_str = "STA";
-            break;
-        case WIFI_MODE_AP:
-            mode_str = "AP";
-            break;
-        case WIFI_MODE_APSTA:
-            mode_str = "AP+STA";
-            break;
-        default:
-            break;
+    /* 剔除仍在退避期内的网络 */
+    int64_t now_us = esp_timer_get_time();
+    uint8_t kept   = 0;
+    for (uint8_t i = 0; i < s_wifi_candidate_num; i++) {
+        if (!wifi_manage_backoff_active(s_wifi_candidates[i].ssid, now_us)) {
+            s_wifi_candidates[kept++] = s_wifi_candidates[i];
         }
-
-        strncpy(out->mode, mode_str, sizeof(out->mode));
-        out->mode[sizeof(out->mode) - 1] = '\0';
+    }
+    if (kept != s_wifi_candidate_num) {
+        ESP_LOGI(TAG, "select: %u candidate(s) backing off", (unsigned)(s_wifi_candidate_num - kept));
+        s_wifi_candidate_num = kept;
     }
 
-    return ESP_OK;
+    s_wifi_round_ready    = true;
+    s_wifi_select_scan_id = 0;
+    s_wifi_pin_first      = false;
+    if (s_reconnect_timer != NULL) {
+        (void)xTimerStop(s_reconnect_timer, 0);   /* 停止选网扫描超时计时 */
+    }
 }
 
-/* -------------------- Web 回调：已保存 WiFi 列表与删除 -------------------- */
 /**
- * @brief 提供给 Web 的“已保存 WiFi 列表”回调
+ * @brief 为新一轮连接准备候选列表
+ *
+ * 近期（scan_cache_ttl_ms 内）已有成功扫描时直接复用；已有扫描进行中时等待该扫描；
+ * 否则发起一次新扫描，完成后由 SCAN_DONE 消息再次驱动状态机。
+ *
+ * @return true 候选已就绪；false 正在等待选网扫描完成
  */
-static esp_err_t wifi_manage_get_web_saved_list(web_saved_wifi_info_t *list, size_t *inout_cnt)
+static bool wifi_manage_prepare_round(void)
 {
-    if (inout_cnt == NULL) {
-        return ESP_ERR_INVALID_ARG;
+    if (s_wifi_round_ready) {
+        return true;
     }
 
-    /* 读取配置允许的最大保存数量，该值也限制存储层条目上限 */
-    uint8_t max_num = (s_wifi_cfg.save_wifi_count <= 0)
-                          ? 1
-                          : (uint8_t)s_wifi_cfg.save_wifi_count;
-
-    if (max_num == 0) {
-        *inout_cnt = 0;
-        return ESP_OK;
+    if (s_wifi_skip_select) {
+        s_wifi_skip_select = false;
+        wifi_manage_rank_from_scan(0);
+        return true;
     }
 
-    /* 为避免在栈上分配大数组，这里通过堆申请临时缓冲区 */
-    wifi_config_t *configs = (wifi_config_t *)malloc(max_num * sizeof(wifi_config_t));
-    if (configs == NULL) {
-        *inout_cnt = 0;
-        return ESP_ERR_NO_MEM;
-    }
+    wifi_module_scan_info_t info;
+    (void)wifi_module_scan_get_info(&info);
 
-    uint8_t   count = 0;
-    esp_err_t ret   = wifi_storage_load_all(configs, &count);
-    if (ret != ESP_OK) {
-        free(configs);
-        *inout_cnt = 0;
-        return ret;
+    if (s_wifi_select_scan_id != 0) {
+        /* 等待中：所等扫描（或其后更新的一次）完成后即可排序 */
+        if (info.done_id == 0 || info.done_id < s_wifi_select_scan_id) {
+            return false;
+        }
+        wifi_manage_rank_from_scan(info.done_id);
+        return true;
     }
 
-    if (count > max_num) {
-        count = max_num;
+    if (!info.running && info.done_id != 0 && info.done_status == ESP_OK &&
+        s_wifi_cfg.scan_cache_ttl_ms > 0) {
+        int64_t age_ms = (esp_timer_get_time() - info.done_time_us) / 1000;
+        if (age_ms <= (int64_t)s_wifi_cfg.scan_cache_ttl_ms) {
+            wifi_manage_rank_from_scan(info.done_id);
+            return true;
+        }
     }
 
-    if (list == NULL) {
-        /* 仅查询数量，不返回具体内容 */
-        *inout_cnt = count;
-        free(configs);
-        return ESP_OK;
+    uint32_t scan_id = 0;
+    if (info.running) {
+        scan_id = info.running_id;
+    } else if (wifi_module_scan_start(&scan_id) != ESP_OK) {
+        scan_id = (wifi_module_scan_get_info(&info) == ESP_OK && info.running) ? info.running_id : 0;
     }
 
-    /* 实际可写入的条目数取决于调用方提供的容量与已有数量 */
-    size_t cap = *inout_cnt;
-    if (cap == 0) {
-        free(configs);
-        *inout_cnt = 0;
-        return ESP_ERR_INVALID_ARG;
-    }
-    if (cap > count) {
-        cap = count;
+    if (scan_id == 0) {
+        wifi_manage_rank_from_scan(0);
+        return true;
     }
 
-    for (size_t i = 0; i < cap; i++) {
-        strncpy(list[i].ssid, (const char *)configs[i].sta.ssid, sizeof(list[i].ssid));
-        list[i].ssid[sizeof(list[i].ssid) - 1] = '\0';
+    /* 借用重连定时器作为扫描超时保护，到期投递 RETRY 后退回按已保存顺序尝试 */
+    s_wifi_select_scan_id = scan_id;
+    if (s_reconnect_timer != NULL) {
+        (void)xTimerChangePeriod(s_reconnect_timer,
+                                 pdMS_TO_TICKS(WIFI_MANAGE_SELECT_SCAN_TIMEOUT_MS), 0);
     }
+    return false;
+}
 
-    free(configs);
+/* -------------------- 连接失败原因分类 -------------------- */
 
-    *inout_cnt = cap;
-    return ESP_OK;
+/*
+ * 按驱动给出的断开原因决定下一步：
+ * - TRANSIENT：信标超时、关联被拒等临时性故障，原地重试同一 AP，最多 max_retry_count 次；
+ * - NOT_FOUND：找不到 AP（或安全方式不匹配），定向连接时先改用普通连接，否则换下一个候选；
+ * - AUTH     ：握手 / 认证失败，基本可确定密码错误，立即换下一个候选并按上限退避。
+ */
+typedef enum {
+    WIFI_MANAGE_FAIL_TRANSIENT = 0,
+    WIFI_MANAGE_FAIL_NOT_FOUND,
+    WIFI_MANAGE_FAIL_AUTH,
+    WIFI_MANAGE_FAIL_TIMEOUT,     /* 管理层阶段超时（见 WIFI_MANAGE_PHASE_*），不来自原因码 */
+} wifi_manage_fail_class_t;
+
+static const struct {
+    uint16_t                 reason;
+    wifi_manage_fail_class_t cls;
+} s_wifi_fail_reason_table[] = {
+    { WIFI_REASON_MIC_FAILURE,                         WIFI_MANAGE_FAIL_AUTH      },
+    { WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT,              WIFI_MANAGE_FAIL_AUTH      },
+    { WIFI_REASON_802_1X_AUTH_FAILED,                  WIFI_MANAGE_FAIL_AUTH      },
+    { WIFI_REASON_AUTH_FAIL,                           WIFI_MANAGE_FAIL_AUTH      },
+    { WIFI_REASON_HANDSHAKE_TIMEOUT,                   WIFI_MANAGE_FAIL_AUTH      },
+    { WIFI_REASON_NO_AP_FOUND,                         WIFI_MANAGE_FAIL_NOT_FOUND },
+    { WIFI_REASON_NO_AP_FOUND_W_COMPATIBLE_SECURITY,   WIFI_MANAGE_FAIL_NOT_FOUND },
+    { WIFI_REASON_NO_AP_FOUND_IN_AUTHMODE_THRESHOLD,   WIFI_MANAGE_FAIL_NOT_FOUND },
+    { WIFI_REASON_NO_AP_FOUND_IN_RSSI_THRESHOLD,       WIFI_MANAGE_FAIL_NOT_FOUND },
+};
+
+static wifi_manage_fail_class_t wifi_manage_classify_reason(uint16_t reason)
+{
+    for (size_t i = 0; i < sizeof(s_wifi_fail_reason_table) / sizeof(s_wifi_fail_reason_table[0]); i++) {
+        if (s_wifi_fail_reason_table[i].reason == reason) {
+            return s_wifi_fail_reason_table[i].cls;
+        }
+    }
+    return WIFI_MANAGE_FAIL_TRANSIENT;
 }
 
 /**
- * @brief 提供给 Web 的“删除已保存 WiFi”回调
+ * @brief 放弃当前候选，记录退避并切换到下一个
  */
-static esp_err_t wifi_manage_delete_web_saved(const char *ssid)
+static void wifi_manage_next_candidate(bool demote)
 {
-    return wifi_storage_delete_by_ssid(ssid);
+    if (s_wifi_round_ready && s_wifi_try_index < s_wifi_candidate_num) {
+        wifi_manage_backoff_on_fail(s_wifi_candidates[s_wifi_try_index].ssid, demote);
+    }
+    s_wifi_try_index++;
+    s_wifi_hint_failed = false;
+    s_wifi_try_retries = 0;
 }
 
-/* -------------------- Web 回调：扫描附近 WiFi -------------------- */
 /**
- * @brief 提供给 Web 的“扫描附近 WiFi”回调
+ * @brief 一次连接尝试拿到 IP 后记录各阶段耗时
  *
- * 通过底层 wifi_module_scan 获取一次附近 AP 列表，
- * 并转换为 Web 端展示所需的精简字段。
+ * @return 从发起连接到获取 IP 的耗时（ms），时间戳不完整时返回 0
  */
-static esp_err_t wifi_manage_scan_web(web_scan_result_t *list, size_t *inout_cnt)
+static uint32_t wifi_manage_metrics_on_got_ip(const wifi_module_status_t *st)
 {
-    if (list == NULL || inout_cnt == NULL || *inout_cnt == 0) {
-        return ESP_ERR_INVALID_ARG;
-    }
-
-    ESP_LOGI(TAG, "web scan request: max_cnt=%u", (unsigned)(*inout_cnt));
-
-    uint16_t cap = (uint16_t)(*inout_cnt);
-    wifi_module_scan_result_t *results =
-        (wifi_module_scan_result_t *)malloc(cap * sizeof(wifi_module_scan_result_t));
-    if (results == NULL) {
-        *inout_cnt = 0;
-        return ESP_ERR_NO_MEM;
-    }
-
-    uint16_t count = cap;
-    esp_err_t ret = wifi_module_scan(results, &count);
-    if (ret != ESP_OK) {
-        free(results);
-        *inout_cnt = 0;
-        return ret;
-    }
-
-    ESP_LOGI(TAG, "wifi scan done: count=%u", (unsigned)count);
-
-    size_t out_cnt = (size_t)count;
-    if (out_cnt > *inout_cnt) {
-        out_cnt = *inout_cnt;
+    const wifi_module_timing_t *t        = &st->timing;
+    uint32_t                    total_ms = 0;
+
+    wifi_metrics_count(st->ssid, WIFI_METRICS_COUNTER_CONNECT_OK);
+
+    if (t->connect_start_us > 0 && t->connected_us >= t->connect_start_us &&
+        t->got_ip_us >= t->connected_us) {
+        wifi_metrics_observe(st->ssid, WIFI_METRICS_PHASE_ASSOC,
+                             (uint32_t)((t->connected_us - t->connect_start_us) / 1000));
+        wifi_metrics_observe(st->ssid, WIFI_METRICS_PHASE_DHCP,
+                             (uint32_t)((t->got_ip_us - t->connected_us) / 1000));
+        total_ms = (uint32_t)((t->got_ip_us - t->connect_start_us) / 1000);
+        wifi_metrics_observe(st->ssid, WIFI_METRICS_PHASE_TOTAL, total_ms);
     }
-
-    for (size_t i = 0; i < out_cnt; i++) {
-        strncpy(list[i].ssid, results[i].ssid, sizeof(list[i].ssid));
-        list[i].ssid[sizeof(list[i].ssid) - 1] = '\0';
-        list[i].rssi = results[i].rssi;
+    if (s_wifi_lost_us > 0 && t->got_ip_us >= s_wifi_lost_us) {
+        wifi_metrics_observe(st->ssid, WIFI_METRICS_PHASE_RECOVERY,
+                             (uint32_t)((t->got_ip_us - s_wifi_lost_us) / 1000));
     }
-
-    free(results);
-    *inout_cnt = out_cnt;
-    return ESP_OK;
+    s_wifi_lost_us = 0;
+    return total_ms;
 }
 
-/* -------------------- Web 回调：从已保存列表触发连接 -------------------- */
 /**
- * @brief 提供给 Web 的“连接已保存 WiFi”回调
+ * @brief 结束一次失败的连接尝试
  *
- * 实现思路：
- * 1. 在存储列表中找到目标 SSID，并通过 wifi_storage_on_connected()
- *    将其提升为最高优先级；
- * 2. 主动断开当前 STA 连接，让已有状态机在收到“断开”事件后，
- *    按最新的优先级顺序自动重连。
+ * 被网页请求打断或手动连接失败时不计入候选失败，重新开始一轮；
+ * 否则按原因决定原地重试、改用普通连接还是换下一个候选。
  *
- * 不直接改动状态机内部逻辑，仅通过“调整优先级 + 触发一次断开”
- * 来驱动后续行为，避免与自动重连策略产生直接冲突。
+ * @param timed_out 阶段超时后主动放弃（不再原地重试）
  */
-static esp_err_t wifi_manage_connect_web_saved(const char *ssid)
+static void wifi_manage_on_attempt_failed(uint16_t reason, bool timed_out)
 {
-    if (ssid == NULL || ssid[0] == '\0') {
-        return ESP_ERR_INVALID_ARG;
-    }
-
-    /* 读取当前已保存列表，确认该 SSID 存在 */
-    uint8_t max_num = (s_wifi_cfg.save_wifi_count <= 0)
-                          ? 1
-                          : (uint8_t)s_wifi_cfg.save_wifi_count;
+    s_wifi_connecting = false;
+    wifi_manage_phase_enter(WIFI_MANAGE_PHASE_NONE, 0);
 
-    wifi_config_t *configs = (wifi_config_t *)malloc(max_num * sizeof(wifi_config_t));
-    if (configs == NULL) {
-        return ESP_ERR_NO_MEM;
+    if (!s_wifi_preempting) {
+        wifi_metrics_count(s_wifi_attempt_ssid, WIFI_METRICS_COUNTER_CONNECT_FAIL);
+        if (wifi_storage_on_failed(s_wifi_attempt_ssid) == ESP_OK) {
+            wifi_manage_schedule_flush();
+        }
     }
 
-    uint8_t   count = 0;
-    esp_err_t ret   = wifi_storage_load_all(configs, &count);
-    if (ret != ESP_OK || count == 0) {
-        free(configs);
-        return ret;
+    if (s_wifi_preempting || s_wifi_manual) {
+        ESP_LOGI(TAG, "%s attempt ended, reason=%u",
+                 s_wifi_preempting ? "preempted" : "manual", (unsigned)reason);
+        s_wifi_preempting = false;
+        s_wifi_manual     = false;
+        wifi_manage_reset_round();
+        (void)web_module_notify_status();
+        return;
     }
 
-    int found_index = -1;
-    for (uint8_t i = 0; i < count; i++) {
-        if (configs[i].sta.ssid[0] == '\0') {
-            continue;
-        }
-        if (strncmp((const char *)configs[i].sta.ssid,
-                    ssid,
-                    sizeof(configs[i].sta.ssid)) == 0) {
-            found_index = (int)i;
-            break;
+    wifi_manage_fail_class_t cls   = timed_out ? WIFI_MANAGE_FAIL_TIMEOUT
+                                               : wifi_manage_classify_reason(reason);
+    int                      limit = (s_wifi_cfg.max_retry_count > 0) ? s_wifi_cfg.max_retry_count : 0;
+
+    ESP_LOGW(TAG, "connect attempt failed: reason=%u class=%d retries=%u",
+             (unsigned)reason, (int)cls, (unsigned)s_wifi_try_retries);
+
+    switch (cls) {
+    case WIFI_MANAGE_FAIL_TRANSIENT:
+        /* 临时性故障：保持定向方式原地重试，次数用尽后换下一个 */
+        if ((int)s_wifi_try_retries < limit && s_wifi_try_retries < UINT8_MAX) {
+            s_wifi_try_retries++;
+        } else {
+            wifi_manage_next_candidate(false);
         }
-    }
+        break;
 
-    if (found_index < 0) {
-        free(configs);
-        return ESP_ERR_NOT_FOUND;
-    }
+    case WIFI_MANAGE_FAIL_TIMEOUT:
+        wifi_manage_next_candidate(false);
+        break;
 
-    /* 通过存储模块将该配置提升为最高优先级 */
-    ret = wifi_storage_on_connected(&configs[found_index]);
-    free(configs);
+    case WIFI_MANAGE_FAIL_NOT_FOUND:
+        /* AP 可能换了信道 / BSSID：定向连接失败时对同一条目改用普通连接 */
+        if (s_wifi_try_hinted) {
+            s_wifi_hint_failed = true;
+        } else {
+            wifi_manage_next_candidate(false);
+        }
+        break;
 
-    if (ret != ESP_OK) {
-        return ret;
+    case WIFI_MANAGE_FAIL_AUTH:
+    default:
+        wifi_manage_next_candidate(true);
+        break;
     }
+    s_wifi_try_hinted = false;
 
-    /* 主动断开当前连接，让状态机在后续收到“断开”事件后，
-     * 按最新优先级从首选 WiFi 开始重新尝试连接。 */
-    (void)esp_wifi_disconnect();
-
-    return ESP_OK;
+    /* 网页端状态由“正在连接”回到“未连接” */
+    (void)web_module_notify_status();
 }
 
-/* -------------------- Web 回调：表单连接 WiFi -------------------- */
+/* -------------------- WiFi 模块事件处理 -------------------- */
 /**
- * @brief 提供给 Web 的“表单连接 WiFi”回调
- *
+ * @brief 在管理任务中处理一条 WiFi 模块事件，更新状态机
  */
-static esp_err_t wifi_manage_connect_web_form(const char *ssid, const char *password)
+static void wifi_manage_handle_wifi_event(wifi_module_event_t event, uint16_t reason)
 {
-    if (ssid == NULL || ssid[0] == '\0') {
-        return ESP_ERR_INVALID_ARG;
+    if (event == WIFI_MODULE_EVENT_STA_DISCONNECTED && s_wifi_connecting) {
+        /* 已关联但尚未拿到 IP 时断开，仍属于本次尝试失败 */
+        event = WIFI_MODULE_EVENT_STA_CONNECT_FAILED;
     }
-    
-    const char *pwd = (password != NULL && password[0] != '\0') ? password : NULL;
 
-    return wifi_module_connect(ssid, pwd);
-}
-
-/* -------------------- WiFi 模块事件回调 -------------------- */
-/**
- * @brief 供 WiFi 模块调用的事件回调，用于驱动管理状态机
- */
-static void wifi_manage_on_wifi_event(wifi_module_event_t event)
-{
     switch (event) {
     case WIFI_MODULE_EVENT_STA_CONNECTED:
-        /* 已与 AP 建立物理连接，但可能尚未获取 IP，此处仅作占位 */
+        /* 已与 AP 建立链路，开始计算 DHCP 阶段时限 */
+        if (s_wifi_connecting && s_wifi_phase == WIFI_MANAGE_PHASE_ASSOC) {
+            wifi_manage_phase_enter(WIFI_MANAGE_PHASE_DHCP, s_wifi_cfg.dhcp_timeout_ms);
+        }
         break;
 
     case WIFI_MODULE_EVENT_STA_GOT_IP: {
         /* 获取到 IP，认为一次连接流程成功结束 */
+        if (s_reconnect_timer != NULL) {
+            (void)xTimerStop(s_reconnect_timer, 0);
+        }
+        wifi_module_status_t snapshot;
+        (void)wifi_module_get_status(&snapshot);
+
+        uint32_t time_to_ip_ms = 0;
+        if (s_wifi_connecting) {
+            /* 仅统计由本模块发起的连接（排除已连接状态下 IP 变化等重复事件） */
+            time_to_ip_ms = wifi_manage_metrics_on_got_ip(&snapshot);
+        }
+        memcpy(s_wifi_link_ssid, snapshot.ssid, sizeof(s_wifi_link_ssid));
+
+        wifi_manage_phase_enter(WIFI_MANAGE_PHASE_NONE, 0);
         wifi_manage_notify_state(WIFI_MANAGE_STATE_CONNECTED);
-        s_wifi_connecting   = false;
-        s_wifi_try_index    = 0;      /* 下次自动重连从首选 WiFi 开始 */
-        s_connect_failed_ts = 0;
+        s_wifi_connecting = false;
+        s_wifi_manual     = false;
+        s_wifi_pin_first  = false;
+        wifi_manage_reset_round();    /* 下次断开后重新选网 */
 
-        /* 将当前配置上报给存储模块，用于调整优先级等策略 */
+        wifi_manage_backoff_clear(snapshot.ssid);
+
+        /* 将当前配置上报给存储模块，用于调整优先级等策略；
+         * 同时记录所连 AP 的 BSSID / 信道 / 认证方式，供下次定向快速重连 */
         wifi_config_t current_cfg = {0};
         if (esp_wifi_get_config(WIFI_IF_STA, &current_cfg) == ESP_OK) {
-            (void)wifi_storage_on_connected(&current_cfg);
+            if (snapshot.channel != 0) {
+                current_cfg.sta.bssid_set          = true;
+                memcpy(current_cfg.sta.bssid, snapshot.bssid, sizeof(current_cfg.sta.bssid));
+                current_cfg.sta.channel            = snapshot.channel;
+                current_cfg.sta.threshold.authmode = snapshot.authmode;
+            }
+            (void)wifi_storage_on_connected(&current_cfg, time_to_ip_ms);
+            wifi_manage_schedule_flush();
         }
         break;
     }
 
     case WIFI_MODULE_EVENT_STA_DISCONNECTED:
-        /* 连接断开，等待管理任务按策略进行重连 */
+        /* 连接断开，随后由状态机立即按策略重连 */
+        ESP_LOGI(TAG, "connection lost, reason=%u", (unsigned)reason);
+        if (s_wifi_preempting) {
+            /* 为执行网页连接请求而主动断开，断开已完成 */
+            s_wifi_preempting = false;
+            wifi_manage_phase_enter(WIFI_MANAGE_PHASE_NONE, 0);
+        } else if (s_wifi_manage_state == WIFI_MANAGE_STATE_CONNECTED) {
+            /* 意外掉线：计数并开始计算恢复耗时 */
+            wifi_module_status_t snapshot;
+            (void)wifi_module_get_status(&snapshot);
+            wifi_metrics_count(s_wifi_link_ssid, WIFI_METRICS_COUNTER_DISCONNECT);
+            s_wifi_lost_us = (snapshot.timing.disconnected_us > 0) ? snapshot.timing.disconnected_us
+                                                                   : esp_timer_get_time();
+        }
         wifi_manage_notify_state(WIFI_MANAGE_STATE_DISCONNECTED);
-        s_wifi_connecting   = false;
-        s_wifi_try_index    = 0;
+        s_wifi_connecting = false;
+        wifi_manage_reset_round();
         break;
 
     case WIFI_MODULE_EVENT_STA_CONNECT_FAILED:
-        /* 本次尝试失败，简单移动到下一条配置 */
-        s_wifi_connecting = false;
-        s_wifi_try_index++;
+        if (!s_wifi_connecting) {
+            /* 不是状态机发起的尝试，或已因超时放弃 */
+            break;
+        }
+        wifi_manage_on_attempt_failed(reason, s_wifi_phase == WIFI_MANAGE_PHASE_ABORT);
+        break;
+
+    default:
+        /* 其他事件暂不关心 */
+        break;
+    }
+}
+
+/**
+ * @brief 供 WiFi 模块调用的事件回调（事件循环任务上下文）
+ *
+ * 只做转发：影响状态机的事件投递给管理任务处理，不在事件循环中做存储读写或发起连接。
+ */
+static void wifi_manage_on_wifi_event(wifi_module_event_t event, uint16_t reason)
+{
+    switch (event) {
+    case WIFI_MODULE_EVENT_STA_RSSI_CHANGED:
+        /* 信号强度明显变化，仅需刷新网页端展示 */
+        (void)web_module_notify_status();
+        break;
+
+    case WIFI_MODULE_EVENT_STA_CONNECTED:
+    case WIFI_MODULE_EVENT_STA_GOT_IP:
+    case WIFI_MODULE_EVENT_STA_DISCONNECTED:
+    case WIFI_MODULE_EVENT_STA_CONNECT_FAILED:
+    case WIFI_MODULE_EVENT_SCAN_DONE:         /* 可能是选网扫描完成，由状态机检查 */
+        wifi_manage_post(WIFI_MANAGE_MSG_WIFI_EVENT, event, reason);
         break;
 
     default:
@@ -409,54 +1403,68 @@ static void wifi_manage_on_wifi_event(wifi_module_event_t event)
  * @brief 单步执行 WiFi 管理状态机
  *
  * 按当前状态决定是否发起连接、切换状态或等待重试。
+ *
+ * @return true 表示状态已推进但尚未进入等待（如跳过了一条无效配置），应立即再执行一步；
+ *         false 表示已发起连接或无事可做，等待下一条消息
  */
-static void wifi_manage_step(void)
+static bool wifi_manage_step(void)
 {
     switch (s_wifi_manage_state) {
     case WIFI_MANAGE_STATE_DISCONNECTED: {
-        /* 断开状态：按顺序遍历已保存 WiFi，逐个尝试连接 */
+        /* 断开状态：先选网，再按候选顺序逐个尝试连接 */
 
         if (s_wifi_connecting) {
             /* 已经有一个连接操作在进行，等待事件回调给结果 */
             break;
         }
 
-        /* 从存储模块加载全部配置，数量受 save_wifi_count 限制 */
-        uint8_t max_num = (s_wifi_cfg.save_wifi_count <= 0)
-                              ? 1
-                              : (uint8_t)s_wifi_cfg.save_wifi_count;
+        /* 已保存数量来自存储模块的内存索引，不访问 Flash */
+        uint16_t count = 0;
 
-        /* 为避免在任务栈上分配大数组，这里通过堆申请临时缓冲区 */
-        wifi_config_t *list = (wifi_config_t *)malloc(max_num * sizeof(wifi_config_t));
-        if (list == NULL) {
-            /* 内存不足时保留在断开状态，等待下次循环再尝试 */
+        if (wifi_storage_get_count(&count) != ESP_OK || count == 0) {
+            /* 没有可用配置，交由上层决定是否启用纯 AP 配网等逻辑 */
             break;
         }
 
-        uint8_t count = 0;
-
-        if (wifi_storage_load_all(list, &count) != ESP_OK || count == 0) {
-            /* 没有可用配置，交由上层决定是否启用纯 AP 配网等逻辑 */
-            free(list);
+        if (!wifi_manage_prepare_round()) {
+            /* 等待选网扫描完成 */
             break;
         }
 
-        if (s_wifi_try_index >= count) {
-            /* 本轮所有配置均尝试过，仍未连接成功，进入“整轮失败”状态 */
+        if (s_wifi_try_index >= s_wifi_candidate_num) {
+            /* 本轮所有候选均尝试过，仍未连接成功，进入“整轮失败”状态 */
             wifi_manage_notify_state(WIFI_MANAGE_STATE_CONNECT_FAILED);
-            s_connect_failed_ts = xTaskGetTickCount();
-            s_wifi_try_index    = 0;
-            s_wifi_connecting   = false;
-            free(list);
+            s_wifi_connecting = false;
+            wifi_manage_reset_round();
+
+            /* 到最早一个网络退避期满时投递 RETRY（没有处于退避期的网络时按 reconnect_interval_ms）；
+             * <0 表示关闭自动重连。间隔为 0 时也至少等待 1 个 tick，避免连接接口持续同步失败时空转。 */
+            if (s_wifi_cfg.reconnect_interval_ms >= 0 && s_reconnect_timer != NULL) {
+                int64_t wait_ms = wifi_manage_backoff_next_ms();
+                if (wait_ms < 0) {
+                    wait_ms = s_wifi_cfg.reconnect_interval_ms;
+                }
+                if (wait_ms > WIFI_MANAGE_BACKOFF_HARD_MAX_MS) {
+                    wait_ms = WIFI_MANAGE_BACKOFF_HARD_MAX_MS;   /* 换算为 tick 前限幅，见上 */
+                }
+                TickType_t period = pdMS_TO_TICKS(wait_ms);
+                if (period == 0) {
+                    period = 1;
+                }
+                (void)xTimerChangePeriod(s_reconnect_timer, period, 0);
+            }
             break;
         }
 
-        wifi_config_t *cfg = &list[s_wifi_try_index];
-        if (cfg->sta.ssid[0] == '\0') {
-            /* 跳过无效 SSID */
+        /* 读取候选对应的已保存配置（选网后可能已被网页删除） */
+        const wifi_manage_candidate_t *cand = &s_wifi_candidates[s_wifi_try_index];
+        wifi_config_t                 *cfg  = &s_wifi_try_cfg;
+
+        if (wifi_storage_find(cand->ssid, cfg) != ESP_OK) {
             s_wifi_try_index++;
-            free(list);
-            break;
+            s_wifi_hint_failed = false;
+            s_wifi_try_retries = 0;
+            return true;
         }
 
         const char *ssid     = (const char *)cfg->sta.ssid;
@@ -464,61 +1472,218 @@ static void wifi_manage_step(void)
                                    ? NULL
                                    : (const char *)cfg->sta.password;
 
-        /* 尝试发起连接，成功则等待事件回调，失败则立即切换到下一条 */
-        if (wifi_module_connect(ssid, password) == ESP_OK) {
+        /* 优先定向连接本轮扫描中最强的 AP；未扫描到时使用上次成功连接记录的 BSSID / 信道 */
+        wifi_module_ap_hint_t        hint;
+        const wifi_module_ap_hint_t *hint_ptr = NULL;
+
+        if (s_wifi_hint_failed) {
+            /* 定向连接已失败，本次改用普通连接 */
+        } else if (cand->has_hint) {
+            hint     = cand->hint;
+            hint_ptr = &hint;
+        } else if (cfg->sta.bssid_set && cfg->sta.channel != 0) {
+            memcpy(hint.bssid, cfg->sta.bssid, sizeof(hint.bssid));
+            hint.channel  = cfg->sta.channel;
+            hint.authmode = cfg->sta.threshold.authmode;
+            hint_ptr      = &hint;
+        }
+
+        /* 尝试发起连接，成功则等待事件回调，失败则立即切换到普通连接 / 下一条 */
+        s_wifi_attempt_gen++;
+        strncpy(s_wifi_attempt_ssid, cand->ssid, sizeof(s_wifi_attempt_ssid) - 1);
+        if (wifi_module_connect_with_hint(ssid, password, hint_ptr) == ESP_OK) {
             s_wifi_connecting = true;
+            s_wifi_try_hinted = (hint_ptr != NULL);
+            wifi_manage_phase_enter(WIFI_MANAGE_PHASE_ASSOC, s_wifi_cfg.assoc_timeout_ms);
+            /* 网页端状态切换为“正在连接” */
+            (void)web_module_notify_status();
+            break;
+        }
+
+        if (hint_ptr != NULL) {
+            s_wifi_hint_failed = true;
         } else {
             s_wifi_try_index++;
+            s_wifi_hint_failed = false;
+            s_wifi_try_retries = 0;
         }
-
-        free(list);
-        break;
+        return true;
     }
 
     case WIFI_MANAGE_STATE_CONNECTED:
-        /* 已连接状态下，当前不做周期性操作，保持静默 */
+        /* 已连接状态下，当前不做周期性操作（RSSI 由 WiFi 模块采样并以事件上报） */
         break;
 
-    case WIFI_MANAGE_STATE_CONNECT_FAILED: {
-        /* 一轮全部失败，根据配置的重连间隔决定何时重新遍历 */
+    case WIFI_MANAGE_STATE_CONNECT_FAILED:
+        /* 一轮全部失败，等待重连定时器投递 RETRY */
+        break;
 
-        if (s_wifi_cfg.reconnect_interval_ms < 0) {
-            /* 小于 0 表示关闭自动重连，保持在失败状态 */
-            break;
-        }
+    default:
+        /* 理论上不应到达，保留作防护 */
+        break;
+    }
+
+    return false;
+}
+
+/* -------------------- 网页连接请求 -------------------- */
+/**
+ * @brief 执行待处理的网页连接请求（管理任务上下文）
+ *
+ * 当前已连接或正在尝试时先主动断开，等断开完成（或超过 WIFI_MANAGE_ABORT_GRACE_MS）后再执行，
+ * 避免旧连接的断开事件被算到新连接头上。执行时取走最新一次请求。
+ */
+static void wifi_manage_run_user_connect(void)
+{
+    if (!s_user_conn.pending || s_wifi_preempting) {
+        return;
+    }
 
-        TickType_t now   = xTaskGetTickCount();
-        TickType_t delta = now - s_connect_failed_ts;
-        TickType_t need  = pdMS_TO_TICKS((s_wifi_cfg.reconnect_interval_ms <= 0)
-                                             ? 0
-                                             : s_wifi_cfg.reconnect_interval_ms);
+    if (s_wifi_connecting || s_wifi_manage_state == WIFI_MANAGE_STATE_CONNECTED) {
+        s_wifi_preempting = true;
+        s_wifi_attempt_gen++;
+        wifi_manage_phase_enter(WIFI_MANAGE_PHASE_ABORT, WIFI_MANAGE_ABORT_GRACE_MS);
+        (void)esp_wifi_disconnect();
+        return;
+    }
+
+    bool saved;
+    char ssid[33];
+    char password[65];
+
+    portENTER_CRITICAL(&s_user_conn_lock);
+    saved = s_user_conn.saved;
+    memcpy(ssid, s_user_conn.ssid, sizeof(ssid));
+    memcpy(password, s_user_conn.password, sizeof(password));
+    s_user_conn.pending = false;
+    portEXIT_CRITICAL(&s_user_conn_lock);
+
+    /* 放弃当前一轮（含整轮失败的等待），由本次请求重新开始 */
+    wifi_manage_reset_round();
+    if (s_wifi_manage_state == WIFI_MANAGE_STATE_CONNECT_FAILED) {
+        wifi_manage_notify_state(WIFI_MANAGE_STATE_DISCONNECTED);
+    }
 
-        if (delta >= need) {
-            /* 到达重试时间，从头开始新一轮遍历 */
-            s_wifi_try_index    = 0;
-            s_wifi_connecting   = false;
-            wifi_manage_notify_state(WIFI_MANAGE_STATE_DISCONNECTED);
+    if (saved) {
+        /* 随后的选网中固定最先尝试；存储中的顺序在连接成功后才调整，此处不写 NVS */
+        if (wifi_storage_find(ssid, NULL) != ESP_OK) {
+            ESP_LOGW(TAG, "connect saved \"%s\": entry unavailable", ssid);
+            return;
         }
-        break;
+        s_wifi_pin_first = true;
+        return;
     }
 
-    default:
-        /* 理论上不应到达，保留作防护 */
-        break;
+    s_wifi_attempt_gen++;
+    memcpy(s_wifi_attempt_ssid, ssid, sizeof(s_wifi_attempt_ssid));
+    if (wifi_module_connect(ssid, (password[0] != '\0') ? password : NULL) != ESP_OK) {
+        ESP_LOGW(TAG, "manual connect \"%s\" failed to start", ssid);
+        return;
     }
+    s_wifi_connecting = true;
+    s_wifi_manual     = true;
+    wifi_manage_phase_enter(WIFI_MANAGE_PHASE_ASSOC, s_wifi_cfg.assoc_timeout_ms);
+    (void)web_module_notify_status();
 }
 
 /* -------------------- WiFi 管理任务 -------------------- */
 /**
- * @brief 管理任务：周期性驱动状态机运行
+ * @brief 管理任务：阻塞等待消息，收到后立即推进状态机
+ *
+ * 没有事件时任务完全休眠，连接失败 / 断开后无需等待轮询周期即可尝试下一条配置。
  */
 static void wifi_manage_task(void *arg)
 {
     (void)arg;
 
+    wifi_manage_msg_t msg;
+
     for (;;) {
-        wifi_manage_step();
-        vTaskDelay(pdMS_TO_TICKS(WIFI_MANAGE_STEP_INTERVAL_MS));
+        if (xQueueReceive(s_wifi_manage_queue, &msg, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        switch (msg.type) {
+        case WIFI_MANAGE_MSG_WIFI_EVENT:
+            wifi_manage_handle_wifi_event(msg.event, msg.reason);
+            break;
+
+        case WIFI_MANAGE_MSG_RETRY:
+            /* 仅在整轮失败的等待期内重新开始一轮，其它状态下由事件自然推进 */
+            if (s_wifi_manage_state == WIFI_MANAGE_STATE_CONNECT_FAILED) {
+                if (s_reconnect_timer != NULL) {
+                    (void)xTimerStop(s_reconnect_timer, 0);
+                }
+                s_wifi_connecting = false;
+                wifi_manage_reset_round();
+                wifi_manage_notify_state(WIFI_MANAGE_STATE_DISCONNECTED);
+            } else if (s_wifi_select_scan_id != 0) {
+                /* 选网扫描超时：不再等待扫描，按已保存顺序尝试 */
+                ESP_LOGW(TAG, "select: scan %u not finished, skip ranking", (unsigned)s_wifi_select_scan_id);
+                s_wifi_select_scan_id = 0;
+                s_wifi_round_ready    = false;
+                s_wifi_skip_select    = true;
+            }
+            break;
+
+        case WIFI_MANAGE_MSG_DEADLINE:
+            if (msg.reason != s_wifi_attempt_gen || s_wifi_phase == WIFI_MANAGE_PHASE_NONE) {
+                break;   /* 过期的超时消息 */
+            }
+            if (s_wifi_phase == WIFI_MANAGE_PHASE_ABORT) {
+                /* 主动断开后迟迟没有断开事件，直接放弃本次尝试 / 视为已断开 */
+                ESP_LOGW(TAG, "disconnect not confirmed, moving on");
+                if (s_wifi_connecting) {
+                    wifi_manage_on_attempt_failed(0, true);
+                } else {
+                    s_wifi_preempting = false;
+                    wifi_manage_phase_enter(WIFI_MANAGE_PHASE_NONE, 0);
+                    wifi_manage_reset_round();
+                    wifi_manage_notify_state(WIFI_MANAGE_STATE_DISCONNECTED);
+                }
+            } else if (s_wifi_connecting) {
+                ESP_LOGW(TAG, "%s deadline exceeded, aborting attempt",
+                         (s_wifi_phase == WIFI_MANAGE_PHASE_DHCP) ? "dhcp" : "association");
+                wifi_manage_phase_enter(WIFI_MANAGE_PHASE_ABORT, WIFI_MANAGE_ABORT_GRACE_MS);
+                (void)esp_wifi_disconnect();
+            }
+            break;
+
+        case WIFI_MANAGE_MSG_CMD_CONNECT:
+            /* 实际执行见下方 wifi_manage_run_user_connect() */
+            break;
+
+        case WIFI_MANAGE_MSG_CMD_DELETE:
+            wifi_manage_call_reply(wifi_storage_delete_by_ssid(msg.ssid), 0);
+            break;
+
+        case WIFI_MANAGE_MSG_CMD_SCAN: {
+            uint32_t  job = 0;
+            esp_err_t ret = wifi_manage_do_scan_start(msg.value, &job);
+            wifi_manage_call_reply(ret, job);
+            break;
+        }
+
+        case WIFI_MANAGE_MSG_CMD_IMPORT: {
+            const wifi_manage_import_t *imp = (const wifi_manage_import_t *)msg.arg;
+            wifi_manage_call_reply(wifi_storage_import(imp->configs, imp->count, imp->replace), 0);
+            break;
+        }
+
+        case WIFI_MANAGE_MSG_FLUSH:
+            s_flush_scheduled = false;
+            if (wifi_storage_flush() != ESP_OK) {
+                wifi_manage_schedule_flush();   /* 写入失败，稍后重试 */
+            }
+            break;
+
+        default:
+            break;
+        }
+
+        wifi_manage_run_user_connect();
+        while (wifi_manage_step()) {
+        }
     }
 }
 
@@ -542,6 +1707,73 @@ esp_err_t wifi_manage_init(const wifi_manage_config_t *config)
         s_wifi_cfg = *config;
     }
 
+    /* ---- 创建管理任务消息队列与重连定时器（需早于 WiFi 模块，事件可能随即到达） ---- */
+    if (s_wifi_manage_queue == NULL) {
+        s_wifi_manage_queue = xQueueCreate(WIFI_MANAGE_QUEUE_LEN, sizeof(wifi_manage_msg_t));
+        if (s_wifi_manage_queue == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    if (s_reconnect_timer == NULL) {
+        s_reconnect_timer = xTimerCreate("wifi_reconn",
+                                         pdMS_TO_TICKS(1000),  /* 周期在启动时按配置设置 */
+                                         pdFALSE,
+                                         NULL,
+                                         wifi_manage_reconnect_timer_cb);
+        if (s_reconnect_timer == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    if (s_call_lock == NULL) {
+        s_call_lock = xSemaphoreCreateMutex();
+        s_call_done = xSemaphoreCreateBinary();
+        if (s_call_lock == NULL || s_call_done == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    if (s_flush_timer == NULL) {
+        s_flush_timer = xTimerCreate("wifi_flush",
+                                     pdMS_TO_TICKS(1000),  /* 周期在安排写入时按配置设置 */
+                                     pdFALSE,
+                                     NULL,
+                                     wifi_manage_flush_timer_cb);
+        if (s_flush_timer == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    if (s_attempt_timer == NULL) {
+        s_attempt_timer = xTimerCreate("wifi_attempt",
+                                       pdMS_TO_TICKS(1000),  /* 周期在每个阶段开始时设置 */
+                                       pdFALSE,
+                                       NULL,
+                                       wifi_manage_attempt_timer_cb);
+        if (s_attempt_timer == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    /* ---- 选网候选列表与退避表：候选来自单次扫描结果，容量不必随保存上限增长 ---- */
+    s_wifi_list_cap = (s_wifi_cfg.save_wifi_count <= 0) ? 1
+                    : (s_wifi_cfg.save_wifi_count > WIFI_MODULE_SCAN_MAX_RESULTS) ? WIFI_MODULE_SCAN_MAX_RESULTS
+                    : (uint8_t)s_wifi_cfg.save_wifi_count;
+    if (s_wifi_candidates == NULL) {
+        s_wifi_candidates = (wifi_manage_candidate_t *)calloc(s_wifi_list_cap, sizeof(wifi_manage_candidate_t));
+        s_wifi_backoff    = (wifi_manage_backoff_t *)calloc(s_wifi_list_cap, sizeof(wifi_manage_backoff_t));
+        if (s_wifi_candidates == NULL || s_wifi_backoff == NULL) {
+            free(s_wifi_candidates);
+            free(s_wifi_backoff);
+            s_wifi_candidates = NULL;
+            s_wifi_backoff    = NULL;
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    /* ---- 连接耗时统计（最近使用的网络 + 1 个手动连接的网络，满时淘汰最久未更新的） ---- */
+    esp_err_t ret = wifi_metrics_init((size_t)s_wifi_list_cap + 1);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
     /* ---- 初始化 WiFi 模块 ---- */
     wifi_module_config_t wifi_cfg = WIFI_MODULE_DEFAULT_CONFIG();
 
@@ -568,7 +1800,7 @@ esp_err_t wifi_manage_init(const wifi_manage_config_t *config)
     wifi_cfg.event_cb = wifi_manage_on_wifi_event;
 
     /* 初始化底层 WiFi 模块 */
-    esp_err_t ret = wifi_module_init(&wifi_cfg);
+    ret = wifi_module_init(&wifi_cfg);
     if (ret != ESP_OK) {
         return ret;
     }
@@ -580,7 +1812,9 @@ esp_err_t wifi_manage_init(const wifi_manage_config_t *config)
     if (s_wifi_cfg.save_wifi_count <= 0) {
         storage_cfg.max_wifi_num = 1;
     } else {
-        storage_cfg.max_wifi_num = (uint8_t)s_wifi_cfg.save_wifi_count;
+        storage_cfg.max_wifi_num = (s_wifi_cfg.save_wifi_count > WIFI_STORAGE_MAX_NUM)
+                                       ? WIFI_STORAGE_MAX_NUM
+                                       : (uint16_t)s_wifi_cfg.save_wifi_count;
     }
 
     ret = wifi_storage_init(&storage_cfg);
@@ -599,11 +1833,17 @@ esp_err_t wifi_manage_init(const wifi_manage_config_t *config)
 
         /* 通过回调向 Web 模块暴露当前 WiFi 状态与已保存列表等能力 */
         web_cfg.get_status_cb     = wifi_manage_get_web_status;
-        web_cfg.get_saved_list_cb = wifi_manage_get_web_saved_list;
-        web_cfg.scan_cb           = wifi_manage_scan_web;
+        web_cfg.foreach_saved_cb  = wifi_manage_foreach_web_saved;
+        web_cfg.scan_start_cb     = wifi_manage_scan_start_web;
+        web_cfg.scan_result_cb    = wifi_manage_scan_result_web;
         web_cfg.delete_saved_cb   = wifi_manage_delete_web_saved;
         web_cfg.connect_saved_cb  = wifi_manage_connect_web_saved;
         web_cfg.connect_cb        = wifi_manage_connect_web_form;
+        web_cfg.metrics_cb        = wifi_metrics_write_prometheus;
+        if (s_wifi_cfg.web_saved_transfer) {
+            web_cfg.import_saved_cb = wifi_manage_import_web_saved;
+            web_cfg.export_saved_cb = wifi_manage_export_web_saved;
+        }
 
         ret = web_module_init(&web_cfg);
         if (ret != ESP_OK) {
@@ -624,6 +1864,9 @@ esp_err_t wifi_manage_init(const wifi_manage_config_t *config)
         if (ret_task != pdPASS) {
             return ESP_ERR_NO_MEM;
         }
+
+        /* 启动后立即执行第一步，尝试连接已保存的 WiFi */
+        wifi_manage_post(WIFI_MANAGE_MSG_RETRY, 0, 0);
     }
 
     return ESP_OK;
@@ -0,0 +1,136 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2026-10-16 13:13:38
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2026-10-16 13:13:38
+ * @FilePath: \xn_web_wifi_config\components\xn_web_wifi_manger\test\host\bench_web_json.c
+ * @Description: web_json 主机端基准：流式写入器 vs. 原 snprintf 拼接（扫描结果列表）
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "web_json.h"
+
+/* -------------------- 配置 -------------------- */
+
+#define BENCH_ITEMS       32          ///< 每个响应中的条目数（与扫描上限相当）
+#define BENCH_ITERATIONS  200000      ///< 每种方式的重复次数
+#define BENCH_OLD_BUF     3072        ///< 原实现使用的整块缓冲区大小
+
+typedef struct {
+    char    ssid[33];
+    int8_t  rssi;
+} bench_item_t;
+
+static bench_item_t s_items[BENCH_ITEMS];
+static size_t       s_sent;           ///< 防止编译器优化掉输出
+
+struct httpd_req {
+    int unused;
+};
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t buf_len)
+{
+    (void)r;
+    if (buf != NULL && buf_len > 0) {
+        s_sent += (size_t)buf_len + (unsigned char)buf[buf_len - 1];
+    }
+    return ESP_OK;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/* -------------------- 两种实现 -------------------- */
+
+/**
+ * @brief 原实现：整块缓冲区 + snprintf 逐条拼接，SSID 不做转义
+ */
+static size_t render_snprintf(char *json, size_t size, uint32_t job)
+{
+    size_t offset = 0;
+    int    n;
+
+    n = snprintf(json + offset, size - offset, "{\"job\":%u,\"done\":true,\"items\":[", (unsigned)job);
+    offset += (size_t)n;
+    for (uint32_t i = 0; i < BENCH_ITEMS && offset < size; i++) {
+        n = snprintf(json + offset, size - offset, "%s{\"index\":%u,\"ssid\":\"%s\",\"rssi\":%d}",
+                     (i == 0) ? "" : ",", (unsigned)i, s_items[i].ssid, s_items[i].rssi);
+        if (n < 0) {
+            break;
+        }
+        offset += (size_t)n;
+    }
+    if (offset < size) {
+        n = snprintf(json + offset, size - offset, "]}");
+        offset += (size_t)n;
+    }
+    s_sent += offset + (unsigned char)json[0];
+    return offset;
+}
+
+/**
+ * @brief 新实现：流式写入器，按 WEB_JSON_CHUNK_SIZE 分块发出，SSID 完整转义
+ */
+static void render_writer(httpd_req_t *req, uint32_t job)
+{
+    web_json_writer_t w;
+
+    web_json_init_resp(&w, req);
+    web_json_obj_begin(&w, NULL);
+    web_json_uint(&w, "job", job);
+    web_json_bool(&w, "done", true);
+    web_json_arr_begin(&w, "items");
+    for (uint32_t i = 0; i < BENCH_ITEMS; i++) {
+        web_json_obj_begin(&w, NULL);
+        web_json_uint(&w, "index", i);
+        web_json_str(&w, "ssid", s_items[i].ssid);
+        web_json_int(&w, "rssi", s_items[i].rssi);
+        web_json_obj_end(&w);
+    }
+    web_json_arr_end(&w);
+    web_json_obj_end(&w);
+    (void)web_json_finish(&w);
+}
+
+int main(void)
+{
+    static char      old_buf[BENCH_OLD_BUF];
+    struct httpd_req req;
+    double           t0, t_old, t_new;
+    size_t           bytes;
+
+    for (int i = 0; i < BENCH_ITEMS; i++) {
+        snprintf(s_items[i].ssid, sizeof(s_items[i].ssid), "Network-%02d-%.*s", i, i % 20, "abcdefghijklmnopqrst");
+        s_items[i].rssi = (int8_t)(-30 - i);
+    }
+
+    bytes = render_snprintf(old_buf, sizeof(old_buf), 1);
+
+    t0 = now_ns();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+        render_snprintf(old_buf, sizeof(old_buf), i);
+    }
+    t_old = (now_ns() - t0) / BENCH_ITERATIONS;
+
+    t0 = now_ns();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+        render_writer(&req, i);
+    }
+    t_new = (now_ns() - t0) / BENCH_ITERATIONS;
+
+    printf("scan list: %d items, ~%zu bytes per response, %d iterations\n",
+           BENCH_ITEMS, bytes, BENCH_ITERATIONS);
+    printf("  snprintf (%d B buffer) : %8.0f ns/response\n", BENCH_OLD_BUF, t_old);
+    printf("  web_json (%d B chunks)  : %8.0f ns/response (%.2fx)\n",
+           WEB_JSON_CHUNK_SIZE, t_new, t_old / t_new);
+    printf("  peak buffer            : %d B -> %d B\n", BENCH_OLD_BUF, WEB_JSON_CHUNK_SIZE);
+    return (s_sent == 0) ? 1 : 0;
+}
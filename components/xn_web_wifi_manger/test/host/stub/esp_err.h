@@ -0,0 +1,16 @@
+/*
+ * @Description: 主机测试用的 esp_err.h 替身（只包含主机测试代码用到的部分）
+ */
+
+#ifndef HOST_STUB_ESP_ERR_H
+#define HOST_STUB_ESP_ERR_H
+
+typedef int esp_err_t;
+
+#define ESP_OK                 0
+#define ESP_FAIL               -1
+#define ESP_ERR_NO_MEM         0x101
+#define ESP_ERR_INVALID_ARG    0x102
+#define ESP_ERR_INVALID_STATE  0x103
+
+#endif /* HOST_STUB_ESP_ERR_H */
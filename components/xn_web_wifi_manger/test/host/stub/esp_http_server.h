@@ -0,0 +1,18 @@
+/*
+ * @Description: 主机测试用的 esp_http_server.h 替身
+ *
+ * 只声明 web_json 用到的 httpd_resp_send_chunk()，由各测试程序自行实现（记录或丢弃输出）。
+ */
+
+#ifndef HOST_STUB_ESP_HTTP_SERVER_H
+#define HOST_STUB_ESP_HTTP_SERVER_H
+
+#include <sys/types.h>
+
+#include "esp_err.h"
+
+typedef struct httpd_req httpd_req_t;
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t buf_len);
+
+#endif /* HOST_STUB_ESP_HTTP_SERVER_H */
@@ -0,0 +1,14 @@
+/*
+ * @Description: 主机测试用的 esp_timer.h 替身
+ *
+ * esp_timer_get_time() 由各测试程序自行实现（便于控制时间先后）。
+ */
+
+#ifndef HOST_STUB_ESP_TIMER_H
+#define HOST_STUB_ESP_TIMER_H
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
+
+#endif /* HOST_STUB_ESP_TIMER_H */
@@ -0,0 +1,16 @@
+/*
+ * @Description: 主机测试用的 FreeRTOS.h 替身（临界区在单线程测试中为空操作）
+ */
+
+#ifndef HOST_STUB_FREERTOS_H
+#define HOST_STUB_FREERTOS_H
+
+typedef struct {
+    int unused;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+#define portENTER_CRITICAL(mux)      ((void)(mux))
+#define portEXIT_CRITICAL(mux)       ((void)(mux))
+
+#endif /* HOST_STUB_FREERTOS_H */
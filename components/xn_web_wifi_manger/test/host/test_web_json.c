@@ -0,0 +1,246 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2026-10-16 13:13:38
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2026-10-16 13:13:38
+ * @FilePath: \xn_web_wifi_config\components\xn_web_wifi_manger\test\host\test_web_json.c
+ * @Description: web_json 主机端单元测试（转义、结构、缓冲模式溢出、响应模式分块边界）
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "web_json.h"
+
+/* -------------------- 测试辅助 -------------------- */
+
+static int s_failures = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            s_failures++;                                                   \
+        }                                                                   \
+    } while (0)
+
+/* httpd 替身：记录所有分块，可在第 N 块时返回错误 */
+#define CAPTURE_MAX 8192
+
+static struct {
+    char      data[CAPTURE_MAX];
+    size_t    len;
+    int       chunks;       /* 非结束块数量 */
+    int       end_chunks;   /* 结束块（NULL, 0）数量 */
+    size_t    max_chunk;
+    int       fail_at;      /* 第几块返回错误，0 表示不出错 */
+    int       partial;      /* 除最后一块外未写满 WEB_JSON_CHUNK_SIZE 的块数 */
+    size_t    last_chunk;
+} s_cap;
+
+struct httpd_req {
+    int unused;
+};
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t buf_len)
+{
+    (void)r;
+    if (buf == NULL || buf_len == 0) {
+        s_cap.end_chunks++;
+        return ESP_OK;
+    }
+    if (s_cap.chunks > 0 && s_cap.last_chunk != WEB_JSON_CHUNK_SIZE) {
+        s_cap.partial++;
+    }
+    s_cap.chunks++;
+    if (s_cap.fail_at != 0 && s_cap.chunks == s_cap.fail_at) {
+        return ESP_FAIL;
+    }
+    if ((size_t)buf_len > s_cap.max_chunk) {
+        s_cap.max_chunk = (size_t)buf_len;
+    }
+    if (s_cap.len + (size_t)buf_len <= sizeof(s_cap.data)) {
+        memcpy(s_cap.data + s_cap.len, buf, (size_t)buf_len);
+    }
+    s_cap.len       += (size_t)buf_len;
+    s_cap.last_chunk = (size_t)buf_len;
+    return ESP_OK;
+}
+
+static void capture_reset(void)
+{
+    memset(&s_cap, 0, sizeof(s_cap));
+}
+
+/* -------------------- 用例 -------------------- */
+
+static void test_escape(void)
+{
+    char              out[256];
+    web_json_writer_t w;
+
+    web_json_init_buf(&w, out, sizeof(out));
+    web_json_obj_begin(&w, NULL);
+    web_json_str(&w, "ssid", "a\"b\\c\n\r\t\x01\x1f" "\xe6\x98\x9f");
+    web_json_str(&w, "k\"ey", "");
+    web_json_str(&w, "none", NULL);
+    web_json_obj_end(&w);
+
+    CHECK(web_json_finish(&w) == ESP_OK);
+    CHECK(strcmp(out, "{\"ssid\":\"a\\\"b\\\\c\\n\\r\\t\\u0001\\u001f\xe6\x98\x9f\","
+                      "\"k\\\"ey\":\"\",\"none\":null}") == 0);
+    CHECK(w.total == strlen(out));
+}
+
+static void test_structure(void)
+{
+    char              out[256];
+    web_json_writer_t w;
+
+    web_json_init_buf(&w, out, sizeof(out));
+    web_json_obj_begin(&w, NULL);
+    web_json_int(&w, "neg", -2147483647 - 1);
+    web_json_uint(&w, "max", 4294967295u);
+    web_json_bool(&w, "t", true);
+    web_json_arr_begin(&w, "items");
+    web_json_obj_begin(&w, NULL);
+    web_json_obj_end(&w);
+    web_json_arr_begin(&w, NULL);
+    web_json_arr_end(&w);
+    web_json_bool(&w, NULL, false);
+    web_json_arr_end(&w);
+    web_json_obj_end(&w);
+
+    CHECK(web_json_finish(&w) == ESP_OK);
+    CHECK(strcmp(out, "{\"neg\":-2147483648,\"max\":4294967295,\"t\":true,"
+                      "\"items\":[{},[],false]}") == 0);
+}
+
+static void test_buffer_overflow(void)
+{
+    const char       *expect = "{\"a\":\"xyz\"}";
+    char              out[32];
+    web_json_writer_t w;
+
+    /* 恰好容纳（含结尾 '\0'） */
+    web_json_init_buf(&w, out, strlen(expect) + 1);
+    web_json_obj_begin(&w, NULL);
+    web_json_str(&w, "a", "xyz");
+    web_json_obj_end(&w);
+    CHECK(web_json_finish(&w) == ESP_OK);
+    CHECK(strcmp(out, expect) == 0);
+
+    /* 少 1 字节：报错而不是截断成看似合法的 JSON */
+    web_json_init_buf(&w, out, strlen(expect));
+    web_json_obj_begin(&w, NULL);
+    web_json_str(&w, "a", "xyz");
+    web_json_obj_end(&w);
+    CHECK(web_json_finish(&w) == ESP_ERR_NO_MEM);
+
+    web_json_init_buf(&w, NULL, 0);
+    CHECK(web_json_finish(&w) == ESP_ERR_INVALID_ARG);
+}
+
+static void test_nesting_errors(void)
+{
+    char              out[64];
+    web_json_writer_t w;
+
+    web_json_init_buf(&w, out, sizeof(out));
+    web_json_obj_begin(&w, NULL);
+    CHECK(web_json_finish(&w) == ESP_ERR_INVALID_STATE);
+
+    web_json_init_buf(&w, out, sizeof(out));
+    web_json_arr_end(&w);
+    CHECK(web_json_finish(&w) == ESP_ERR_INVALID_STATE);
+
+    web_json_init_buf(&w, out, sizeof(out));
+    for (int i = 0; i < WEB_JSON_MAX_DEPTH; i++) {
+        web_json_arr_begin(&w, NULL);
+    }
+    CHECK(web_json_finish(&w) == ESP_ERR_INVALID_STATE);
+}
+
+/**
+ * @brief 生成一份内容：转义序列落在分块边界附近的不同位置
+ */
+static void write_payload(web_json_writer_t *w, size_t pad)
+{
+    char ssid[40];
+
+    web_json_obj_begin(w, NULL);
+    web_json_arr_begin(w, "items");
+    for (size_t i = 0; i < 24; i++) {
+        size_t n = (pad + i) % 32;
+        memset(ssid, 'x', n);
+        ssid[n] = '\0';
+        if (n > 2) {
+            ssid[n / 2]     = '"';
+            ssid[n / 2 + 1] = '\x02';
+        }
+        web_json_obj_begin(w, NULL);
+        web_json_uint(w, "index", (uint32_t)i);
+        web_json_str(w, "ssid", ssid);
+        web_json_int(w, "rssi", -40 - (int32_t)i);
+        web_json_obj_end(w);
+    }
+    web_json_arr_end(w);
+    web_json_obj_end(w);
+}
+
+static void test_chunk_boundaries(void)
+{
+    static char       expect[CAPTURE_MAX];
+    struct httpd_req  req;
+    web_json_writer_t w;
+
+    for (size_t pad = 0; pad < 64; pad++) {
+        web_json_init_buf(&w, expect, sizeof(expect));
+        write_payload(&w, pad);
+        CHECK(web_json_finish(&w) == ESP_OK);
+
+        capture_reset();
+        web_json_init_resp(&w, &req);
+        write_payload(&w, pad);
+        CHECK(web_json_finish(&w) == ESP_OK);
+
+        CHECK(s_cap.len == strlen(expect));
+        CHECK(memcmp(s_cap.data, expect, s_cap.len) == 0);
+        CHECK(s_cap.max_chunk <= WEB_JSON_CHUNK_SIZE);
+        CHECK(s_cap.partial == 0);           /* 只有最后一块可以不满 */
+        CHECK(s_cap.end_chunks == 1);
+        CHECK(s_cap.chunks == (int)((s_cap.len + WEB_JSON_CHUNK_SIZE - 1) / WEB_JSON_CHUNK_SIZE));
+    }
+}
+
+static void test_send_error(void)
+{
+    struct httpd_req  req;
+    web_json_writer_t w;
+
+    capture_reset();
+    s_cap.fail_at = 2;
+    web_json_init_resp(&w, &req);
+    write_payload(&w, 7);
+    CHECK(web_json_finish(&w) == ESP_FAIL);
+    CHECK(s_cap.chunks == 2);        /* 出错后不再发送 */
+    CHECK(s_cap.end_chunks == 0);
+}
+
+int main(void)
+{
+    test_escape();
+    test_structure();
+    test_buffer_overflow();
+    test_nesting_errors();
+    test_chunk_boundaries();
+    test_send_error();
+
+    if (s_failures != 0) {
+        fprintf(stderr, "web_json: %d check(s) failed\n", s_failures);
+        return 1;
+    }
+    printf("web_json: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,222 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2026-10-16 13:13:38
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2026-10-16 13:13:38
+ * @FilePath: \xn_web_wifi_config\components\xn_web_wifi_manger\test\host\test_wifi_metrics.c
+ * @Description: wifi_metrics 主机端单元测试（桶边界、累计导出、条目淘汰、标签转义）
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wifi_metrics.h"
+
+/* -------------------- 测试辅助 -------------------- */
+
+static int s_failures = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            s_failures++;                                                   \
+        }                                                                   \
+    } while (0)
+
+/* 统计表容量：淘汰用例依赖该值 */
+#define TEST_MAX_SSIDS 2
+
+/* esp_timer 替身：每次调用前进 1 us，保证条目更新时间严格有序 */
+static int64_t s_now_us = 0;
+
+int64_t esp_timer_get_time(void)
+{
+    return ++s_now_us;
+}
+
+/* 导出输出缓冲 */
+static char   s_out[16384];
+static size_t s_out_len;
+
+static esp_err_t capture_write(void *ctx, const char *data, size_t len)
+{
+    (void)ctx;
+    if (s_out_len + len >= sizeof(s_out)) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(s_out + s_out_len, data, len);
+    s_out_len        += len;
+    s_out[s_out_len]  = '\0';
+    return ESP_OK;
+}
+
+static const char *export_text(void)
+{
+    s_out_len = 0;
+    s_out[0]  = '\0';
+    CHECK(wifi_metrics_write_prometheus(capture_write, NULL) == ESP_OK);
+    return s_out;
+}
+
+/**
+ * @brief 读取某个 SSID 的统计副本
+ */
+static bool find_entry(const char *ssid, wifi_metrics_entry_t *out)
+{
+    wifi_metrics_entry_t entries[TEST_MAX_SSIDS];
+    size_t               n = TEST_MAX_SSIDS;
+
+    CHECK(wifi_metrics_get(entries, &n) == ESP_OK);
+    for (size_t i = 0; i < n; i++) {
+        if (strcmp(entries[i].ssid, ssid) == 0) {
+            *out = entries[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+/* -------------------- 用例 -------------------- */
+
+static void test_bucket_edges(void)
+{
+    static const struct {
+        uint32_t ms;
+        int      bucket;
+    } cases[] = {
+        { 0,     0 },
+        { 100,   0 },   /* 上界本身落在该桶（le） */
+        { 101,   1 },
+        { 250,   1 },
+        { 30000, 7 },   /* 最后一个有限桶 */
+        { 30001, 8 },   /* 超出最大上界进入 +Inf */
+        { UINT32_MAX, 8 },
+    };
+    wifi_metrics_entry_t e;
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        wifi_metrics_reset();
+        wifi_metrics_observe("edge", WIFI_METRICS_PHASE_ASSOC, cases[i].ms);
+        CHECK(find_entry("edge", &e));
+        for (int b = 0; b < WIFI_METRICS_BUCKET_NUM; b++) {
+            CHECK(e.phase[WIFI_METRICS_PHASE_ASSOC].buckets[b] == (b == cases[i].bucket ? 1u : 0u));
+        }
+        CHECK(e.phase[WIFI_METRICS_PHASE_ASSOC].count == 1);
+        CHECK(e.phase[WIFI_METRICS_PHASE_ASSOC].sum_ms == cases[i].ms);
+    }
+
+    /* 无效参数不记录 */
+    wifi_metrics_reset();
+    wifi_metrics_observe("", WIFI_METRICS_PHASE_ASSOC, 1);
+    wifi_metrics_observe(NULL, WIFI_METRICS_PHASE_ASSOC, 1);
+    wifi_metrics_observe("x", WIFI_METRICS_PHASE_NUM, 1);
+    size_t n = 0;
+    CHECK(wifi_metrics_get(NULL, &n) == ESP_OK && n == 0);
+}
+
+static void test_cumulative_export(void)
+{
+    wifi_metrics_reset();
+    wifi_metrics_observe("net", WIFI_METRICS_PHASE_DHCP, 100);    /* le 0.100 */
+    wifi_metrics_observe("net", WIFI_METRICS_PHASE_DHCP, 400);    /* le 0.500 */
+    wifi_metrics_observe("net", WIFI_METRICS_PHASE_DHCP, 1500);   /* le 2.000 */
+    wifi_metrics_observe("net", WIFI_METRICS_PHASE_DHCP, 45000);  /* +Inf */
+    wifi_metrics_count("net", WIFI_METRICS_COUNTER_CONNECT_OK);
+    wifi_metrics_count("net", WIFI_METRICS_COUNTER_CONNECT_FAIL);
+    wifi_metrics_count("net", WIFI_METRICS_COUNTER_CONNECT_FAIL);
+    wifi_metrics_count("net", WIFI_METRICS_COUNTER_DISCONNECT);
+
+    const char *text = export_text();
+    static const char *const expect[] = {
+        "wifi_connect_phase_seconds_bucket{ssid=\"net\",phase=\"dhcp\",le=\"0.100\"} 1\n",
+        "wifi_connect_phase_seconds_bucket{ssid=\"net\",phase=\"dhcp\",le=\"0.250\"} 1\n",
+        "wifi_connect_phase_seconds_bucket{ssid=\"net\",phase=\"dhcp\",le=\"0.500\"} 2\n",
+        "wifi_connect_phase_seconds_bucket{ssid=\"net\",phase=\"dhcp\",le=\"1.000\"} 2\n",
+        "wifi_connect_phase_seconds_bucket{ssid=\"net\",phase=\"dhcp\",le=\"2.000\"} 3\n",
+        "wifi_connect_phase_seconds_bucket{ssid=\"net\",phase=\"dhcp\",le=\"30.000\"} 3\n",
+        "wifi_connect_phase_seconds_bucket{ssid=\"net\",phase=\"dhcp\",le=\"+Inf\"} 4\n",
+        "wifi_connect_phase_seconds_sum{ssid=\"net\",phase=\"dhcp\"} 47.000\n",
+        "wifi_connect_phase_seconds_count{ssid=\"net\",phase=\"dhcp\"} 4\n",
+        "wifi_connect_total{ssid=\"net\",result=\"ok\"} 1\n",
+        "wifi_connect_total{ssid=\"net\",result=\"fail\"} 2\n",
+        "wifi_disconnect_total{ssid=\"net\"} 1\n",
+    };
+    for (size_t i = 0; i < sizeof(expect) / sizeof(expect[0]); i++) {
+        if (strstr(text, expect[i]) == NULL) {
+            fprintf(stderr, "missing line: %s", expect[i]);
+            s_failures++;
+        }
+    }
+
+    /* 没有样本的阶段不输出直方图 */
+    CHECK(strstr(text, "phase=\"assoc\"") == NULL);
+}
+
+static void test_eviction(void)
+{
+    wifi_metrics_entry_t e;
+
+    wifi_metrics_reset();
+    wifi_metrics_count("a", WIFI_METRICS_COUNTER_CONNECT_OK);
+    wifi_metrics_count("b", WIFI_METRICS_COUNTER_CONNECT_OK);
+    wifi_metrics_count("a", WIFI_METRICS_COUNTER_CONNECT_OK);   /* a 变为最近更新 */
+
+    /* 超出容量：淘汰最久未更新的 b，新条目从零开始 */
+    wifi_metrics_count("c", WIFI_METRICS_COUNTER_CONNECT_FAIL);
+    CHECK(find_entry("a", &e) && e.counter[WIFI_METRICS_COUNTER_CONNECT_OK] == 2);
+    CHECK(!find_entry("b", &e));
+    CHECK(find_entry("c", &e) && e.counter[WIFI_METRICS_COUNTER_CONNECT_FAIL] == 1 &&
+          e.counter[WIFI_METRICS_COUNTER_CONNECT_OK] == 0);
+
+    /* b 重新出现时同样淘汰当前最久未更新的 a，且不继承旧数据 */
+    wifi_metrics_observe("b", WIFI_METRICS_PHASE_TOTAL, 10);
+    CHECK(!find_entry("a", &e));
+    CHECK(find_entry("b", &e) && e.counter[WIFI_METRICS_COUNTER_CONNECT_OK] == 0 &&
+          e.phase[WIFI_METRICS_PHASE_TOTAL].count == 1);
+
+    size_t n = 0;
+    CHECK(wifi_metrics_get(NULL, &n) == ESP_OK && n == TEST_MAX_SSIDS);
+}
+
+static void test_label_escape(void)
+{
+    wifi_metrics_reset();
+    wifi_metrics_count("a\"b\\c\nd", WIFI_METRICS_COUNTER_DISCONNECT);
+    CHECK(strstr(export_text(), "wifi_disconnect_total{ssid=\"a\\\"b\\\\c\\nd\"} 1\n") != NULL);
+
+    /* 32 字节全部需要转义时也不截断 */
+    char ssid[33];
+    char expect[128];
+    memset(ssid, '"', 32);
+    ssid[32] = '\0';
+    strcpy(expect, "wifi_disconnect_total{ssid=\"");
+    for (int i = 0; i < 32; i++) {
+        strcat(expect, "\\\"");
+    }
+    strcat(expect, "\"} 1\n");
+
+    wifi_metrics_reset();
+    wifi_metrics_count(ssid, WIFI_METRICS_COUNTER_DISCONNECT);
+    CHECK(strstr(export_text(), expect) != NULL);
+}
+
+int main(void)
+{
+    size_t n = 0;
+    CHECK(wifi_metrics_get(NULL, &n) == ESP_ERR_INVALID_STATE);
+    CHECK(wifi_metrics_init(TEST_MAX_SSIDS) == ESP_OK);
+
+    test_bucket_edges();
+    test_cumulative_export();
+    test_eviction();
+    test_label_escape();
+
+    if (s_failures != 0) {
+        fprintf(stderr, "wifi_metrics: %d check(s) failed\n", s_failures);
+        return 1;
+    }
+    printf("wifi_metrics: all tests passed\n");
+    return 0;
+}
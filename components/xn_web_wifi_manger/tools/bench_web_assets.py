@@ -0,0 +1,117 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# @Author: 星年 && jixingnian@gmail.com
+# @Date: 2026-10-16 13:13:38
+# @FilePath: \xn_web_wifi_config\components\xn_web_wifi_manger\tools\bench_web_assets.py
+# @Description: 网页资源发送性能测试脚本
+#
+"""
+对运行中的设备重复加载配网页面（/、app.css、app.js，不带 If-None-Match，每次都是完整 200 响应），
+分别以 gzip 与 identity 编码各加载 N 次，并在前后读取 /api/metrics 中的 web_asset_* 计数，输出：
+  - 每次页面加载的字节数；
+  - 客户端测得的页面加载耗时；
+  - 设备端发送吞吐（字节数 / 发送耗时）；
+  - 每次页面加载 httpd 任务占用的 CPU 时间（需开启 FreeRTOS 运行时统计，时钟为 esp_timer）。
+
+资源模式（嵌入固件 / 资源包分区 / SPIFFS）是编译期选项，需分别构建烧录后各运行一次，
+例如：
+  python bench_web_assets.py --host 192.168.4.1 -n 50
+"""
+
+import argparse
+import http.client
+import re
+import sys
+import time
+
+PAGE = ['/', '/app.css', '/app.js']
+
+METRIC_RE = re.compile(r'^(web_asset_\w+)\{([^}]*)\}\s+(\S+)$')
+LABEL_RE = re.compile(r'(\w+)="([^"]*)"')
+
+
+def fetch(conn, path, headers=None):
+    conn.request('GET', path, headers=headers or {})
+    resp = conn.getresponse()
+    body = resp.read()
+    if resp.status != 200:
+        raise RuntimeError('GET %s -> %d' % (path, resp.status))
+    return body
+
+
+def read_metrics(conn):
+    """返回 (info 标签, {(series, encoding): 所有资源之和})"""
+    info = {}
+    totals = {}
+    text = fetch(conn, '/api/metrics').decode('utf-8', 'replace')
+    for line in text.splitlines():
+        m = METRIC_RE.match(line)
+        if not m:
+            continue
+        name, labels, value = m.group(1), dict(LABEL_RE.findall(m.group(2))), float(m.group(3))
+        if name == 'web_asset_info':
+            info = labels
+            continue
+        key = (name, labels.get('encoding', ''))
+        totals[key] = totals.get(key, 0.0) + value
+    if not info:
+        raise RuntimeError('/api/metrics has no web_asset_* series (firmware too old?)')
+    return info, totals
+
+
+def run(conn, encoding, count):
+    headers = {'Accept-Encoding': 'gzip' if encoding == 'gzip' else 'identity'}
+    _, before = read_metrics(conn)
+    t0 = time.perf_counter()
+    for _ in range(count):
+        for path in PAGE:
+            fetch(conn, path, headers)
+    client_s = time.perf_counter() - t0
+    _, after = read_metrics(conn)
+
+    def delta(series):
+        return after.get((series, encoding), 0.0) - before.get((series, encoding), 0.0)
+
+    responses = delta('web_asset_responses_total')
+    if responses < count * len(PAGE):
+        raise RuntimeError('expected %d %s responses, device counted %d'
+                           % (count * len(PAGE), encoding, responses))
+    nbytes = delta('web_asset_bytes_total')
+    send_s = delta('web_asset_send_seconds_total')
+    cpu_s = delta('web_asset_cpu_seconds_total')
+    return {
+        'bytes_per_load': nbytes / count,
+        'client_ms': client_s * 1000.0 / count,
+        'send_bps': nbytes / send_s if send_s > 0 else 0.0,
+        'cpu_us': cpu_s * 1e6 / count,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument('--host', default='192.168.4.1', help='设备地址（默认 AP 地址）')
+    parser.add_argument('--port', type=int, default=80)
+    parser.add_argument('-n', '--count', type=int, default=50, help='每种编码的页面加载次数')
+    args = parser.parse_args()
+
+    conn = http.client.HTTPConnection(args.host, args.port, timeout=10)
+    info, _ = read_metrics(conn)
+    cpu = info.get('cpu_stats') == '1'
+
+    print('mode=%s, %d page loads per encoding (%s)' % (info.get('mode', '?'), args.count, ' '.join(PAGE)))
+    print('| mode | encoding | bytes/load | load ms (client) | send B/s (device) | CPU us/load |')
+    print('|------|----------|-----------:|-----------------:|------------------:|------------:|')
+    for encoding in ('gzip', 'identity'):
+        r = run(conn, encoding, args.count)
+        print('| %s | %s | %d | %.1f | %d | %s |' % (
+            info.get('mode', '?'), encoding, r['bytes_per_load'], r['client_ms'],
+            r['send_bps'], ('%.0f' % r['cpu_us']) if cpu else 'n/a'))
+    if not cpu:
+        print('CPU time needs CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS with the esp_timer run time clock',
+              file=sys.stderr)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,141 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# @Author: 星年 && jixingnian@gmail.com
+# @Date: 2026-10-16 10:00:00
+# @FilePath: \xn_web_wifi_config\components\xn_web_wifi_manger\tools\gen_web_assets.py
+# @Description: 构建期网页资源生成脚本
+#
+"""
+将 wifi_spiffs/ 下的静态资源拷贝到构建目录，并为每个资源：
+  - 计算内容哈希（用作 ETag 与 URL 指纹）；
+  - 生成 .gz 预压缩版本；
+供 CMakeLists.txt 嵌入固件或打包进 wifi_spiffs 分区镜像。
+
+可选 --pack：额外生成一个资源包镜像，烧录到 wifi_spiffs 分区后由 web_module.c
+通过 esp_partition_mmap 整体映射，按偏移 / 长度直接发送。格式（小端）：
+  header : magic "XNWA"(u32) version(u16) count(u16)
+  entry  : name[24]（'\0' 填充） offset(u32，相对镜像起始) length(u32)，共 count 项
+  data   : 各资源数据，按 4 字节对齐；gzip 版本以 "<name>.gz" 作为独立条目
+
+HTML 中对其它资源的引用（如 "app.css"）会被改写为带指纹的 URL
+（如 "app.css?v=<hash>"），使 CSS/JS 可以被浏览器长期缓存。
+同时生成 C 头文件，向 web_module.c 提供每个资源的哈希值。
+"""
+
+import argparse
+import gzip
+import hashlib
+import os
+import re
+import struct
+
+PACK_MAGIC = 0x41574E58  # "XNWA"
+PACK_VERSION = 1
+PACK_NAME_LEN = 24
+
+
+def write_file(path, data):
+    with open(path, 'wb') as f:
+        f.write(data)
+
+
+def content_hash(data):
+    """取 SHA-256 前 16 个十六进制字符作为资源指纹。"""
+    return hashlib.sha256(data).hexdigest()[:16]
+
+
+def macro_name(name):
+    """index.html -> WEB_ASSET_INDEX_HTML_HASH"""
+    return 'WEB_ASSET_%s_HASH' % re.sub(r'[^0-9A-Za-z]', '_', name).upper()
+
+
+def build_pack(files):
+    """
+    生成资源包镜像。
+
+    @param files (name, data) 列表
+    """
+    header_size = 8 + len(files) * (PACK_NAME_LEN + 8)
+    offset = (header_size + 3) & ~3
+
+    entries = b''
+    payload = b''
+    for name, data in files:
+        encoded = name.encode()
+        if len(encoded) >= PACK_NAME_LEN:
+            raise ValueError('asset name too long for pack: %s' % name)
+        entries += struct.pack('<%dsII' % PACK_NAME_LEN, encoded, offset + len(payload), len(data))
+        payload += data
+        payload += b'\0' * (-len(payload) & 3)
+
+    header = struct.pack('<IHH', PACK_MAGIC, PACK_VERSION, len(files)) + entries
+    header += b'\0' * (offset - len(header))
+    return header + payload
+
+
+def main():
+    parser = argparse.ArgumentParser(description='generate web assets for xn_web_wifi_manger')
+    parser.add_argument('--src', required=True, help='源资源目录（wifi_spiffs）')
+    parser.add_argument('--out', required=True, help='输出目录（构建目录）')
+    parser.add_argument('--header', required=True, help='生成的 C 头文件路径')
+    parser.add_argument('--pack', help='可选：生成的资源包镜像路径（分区映射模式使用）')
+    parser.add_argument('assets', nargs='+', help='资源文件名列表，如 index.html app.css app.js')
+    args = parser.parse_args()
+
+    os.makedirs(args.out, exist_ok=True)
+    os.makedirs(os.path.dirname(args.header), exist_ok=True)
+
+    contents = {}
+    for name in args.assets:
+        with open(os.path.join(args.src, name), 'rb') as f:
+            contents[name] = f.read()
+
+    # 先处理被引用的资源（CSS/JS），再将其指纹写入 HTML，最后计算 HTML 自身哈希
+    pages = [n for n in args.assets if n.endswith('.html')]
+    others = [n for n in args.assets if n not in pages]
+
+    hashes = {}
+    for name in others:
+        hashes[name] = content_hash(contents[name])
+
+    for page in pages:
+        data = contents[page]
+        for name in others:
+            for quote in (b'"', b"'"):
+                ref = quote + name.encode() + quote
+                fingerprinted = quote + ('%s?v=%s' % (name, hashes[name])).encode() + quote
+                data = data.replace(ref, fingerprinted)
+        contents[page] = data
+        hashes[page] = content_hash(data)
+
+    lines = [
+        '/* 由 tools/gen_web_assets.py 自动生成，请勿手动修改 */',
+        '#pragma once',
+        '',
+    ]
+
+    pack_files = []
+    for name in args.assets:
+        raw = contents[name]
+        # mtime=0 保证相同输入得到逐字节相同的压缩结果（可复现构建）
+        gz = gzip.compress(raw, compresslevel=9, mtime=0)
+
+        write_file(os.path.join(args.out, name), raw)
+        write_file(os.path.join(args.out, name + '.gz'), gz)
+        pack_files.append((name, raw))
+        pack_files.append((name + '.gz', gz))
+
+        lines.append('#define %s "%s"' % (macro_name(name), hashes[name]))
+        print('web asset %-12s %6d -> %6d bytes (gzip), hash %s' % (name, len(raw), len(gz), hashes[name]))
+
+    write_file(args.header, ('\n'.join(lines) + '\n').encode())
+
+    if args.pack:
+        pack = build_pack(pack_files)
+        write_file(args.pack, pack)
+        print('web asset pack %d bytes -> %s' % (len(pack), args.pack))
+
+
+if __name__ == '__main__':
+    main()
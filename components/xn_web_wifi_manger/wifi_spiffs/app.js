@@ -202,10 +202,60 @@
 
   /* -------------------- 已保存 WiFi：渲染与操作 -------------------- */
 
+  /**
+   * 转义 HTML 特殊字符。
+   *
+   * SSID 由附近 AP 决定，可能包含引号、尖括号等字符，
+   * 拼接进 innerHTML / 属性前必须转义。
+   */
+  function escapeHtml(text) {
+    return String(text).replace(/[&<>"']/g, function (c) {
+      return {
+        '&': '&amp;',
+        '<': '&lt;',
+        '>': '&gt;',
+        '"': '&quot;',
+        "'": '&#39;'
+      }[c];
+    });
+  }
+
+  /**
+   * 将一条已保存 WiFi 的连接统计格式化为简短文本。
+   *
+   * 例如 "成功 12 / 失败 3 · 平均 2.1s · 最近 2025-11-24 09:30"。
+   * last_success 小于 2020 年时说明设备未校时（为开机后秒数），不显示日期。
+   */
+  function formatSavedStats(item) {
+    var success = item.success || 0;
+    var fail = item.fail || 0;
+
+    if (success === 0 && fail === 0) {
+      return '-';
+    }
+
+    var parts = ['成功 ' + success + ' / 失败 ' + fail];
+
+    if (item.ip_ms) {
+      parts.push('平均 ' + (item.ip_ms / 1000).toFixed(1) + 's');
+    }
+
+    if (item.last_success && item.last_success > 1577836800) {
+      var d = new Date(item.last_success * 1000);
+      var pad = function (n) {
+        return (n < 10 ? '0' : '') + n;
+      };
+      parts.push('最近 ' + d.getFullYear() + '-' + pad(d.getMonth() + 1) + '-' + pad(d.getDate()) +
+        ' ' + pad(d.getHours()) + ':' + pad(d.getMinutes()));
+    }
+
+    return parts.join(' · ');
+  }
+
   /**
    * 将已保存 WiFi 列表渲染到表格中。
    *
-   * @param items 形如 [{ index, ssid }, ...] 的数组
+   * @param items 形如 [{ index, ssid, success, fail, last_success, ip_ms }, ...] 的数组
    */
   function renderSavedList(items) {
     if (!dom.savedBody) {
@@ -227,12 +277,13 @@
     var rows = [];
     for (var i = 0; i < items.length; i++) {
       var item = items[i] || {};
-      var ssid = item.ssid || '-';
+      var ssid = escapeHtml(item.ssid || '-');
 
       rows.push(
         '<tr>' +
           '<td>' + (i + 1) + '</td>' +
           '<td>' + ssid + '</td>' +
+          '<td>' + formatSavedStats(item) + '</td>' +
           '<td>' +
             '<button type="button" class="btn btn-primary" data-action="connect-saved" data-ssid="' + ssid + '">连接</button>' +
             ' ' +
@@ -321,7 +372,7 @@
     var rows = [];
     for (var i = 0; i < items.length; i++) {
       var item = items[i] || {};
-      var ssid = item.ssid || '-';
+      var ssid = escapeHtml(item.ssid || '-');
       var rssi = typeof item.rssi === 'number' ? item.rssi : null;
 
       var signalText = rssi === null ? '-' : (rssi + ' dBm');
@@ -340,8 +391,13 @@
 
   /**
    * 发起一次“扫描附近 WiFi”的请求。
+   *
+   * 后端扫描为异步任务：/api/wifi/scan 立即返回任务编号，
+   * 随后轮询 /api/wifi/scan/result?job=N 直到 done 为 true。
+   * 页面加载时允许复用后端缓存的结果；手动点击“扫描”时传 fresh=true 要求新结果
+   * （若其他页面正在扫描，后端会合并到同一次扫描）。
    */
-  function loadScanList() {
+  function loadScanList(fresh) {
     if (!dom.scanBody || !window.fetch) {
       return;
     }
@@ -353,12 +409,37 @@
     }
     dom.scanBody.innerHTML = '';
 
-    fetch('/api/wifi/scan')
-      .then(function (res) {
+    function getJson(url) {
+      return fetch(url).then(function (res) {
         if (!res.ok) {
           throw new Error('http ' + res.status);
         }
         return res.json();
+      });
+    }
+
+    // 扫描通常 2~4 秒完成，每 500ms 查询一次，最多等待约 15 秒
+    var pollLeft = 30;
+
+    function pollResult(job) {
+      return getJson('/api/wifi/scan/result?job=' + job).then(function (data) {
+        if (data && data.done) {
+          return data;
+        }
+        if (--pollLeft <= 0) {
+          throw new Error('scan timeout');
+        }
+        return new Promise(function (resolve) {
+          setTimeout(resolve, 500);
+        }).then(function () {
+          return pollResult(job);
+        });
+      });
+    }
+
+    getJson(fresh ? '/api/wifi/scan?max_age=0' : '/api/wifi/scan')
+      .then(function (data) {
+        return pollResult(data.job);
       })
       .then(function (data) {
         var items = (data && data.items) || [];
@@ -391,7 +472,7 @@
         }
       })
       .then(function () {
-        // 连接请求发起后，依赖上方“当前 WiFi 状态”模块的轮询展示进度
+        // 连接请求发起后，依赖上方“当前 WiFi 状态”模块的推送展示进度
       })
       .catch(function () {
         // 连接失败时暂不弹框，由状态模块展示“连接失败”状态
@@ -431,7 +512,7 @@
   /**
    * 启动一个简单的轮询：每隔固定时间刷新一次当前 WiFi 状态。
    *
-   * 间隔设置为 1 秒，足够跟上状态变化，又不会造成明显压力。
+   * 仅在无法使用状态推送时作为后备方案，间隔 1 秒。
    */
   function startStatusPolling() {
     // 先立即拉取一次，保证页面初始状态尽快变为真实状态
@@ -441,6 +522,37 @@
     setInterval(loadStatusOnce, 1000);
   }
 
+  /**
+   * 订阅后端状态推送（Server-Sent Events）。
+   *
+   * - 后端仅在状态变化（连接 / 断开 / 信号变化）时推送一帧，空闲时没有任何请求；
+   * - 连接断开时 EventSource 会按后端给出的 retry 间隔自动重连；
+   * - 浏览器不支持 EventSource，或后端拒绝订阅时，退回到 1 秒轮询。
+   */
+  function startStatusEvents() {
+    if (!window.EventSource) {
+      startStatusPolling();
+      return;
+    }
+
+    var source = new EventSource('/api/wifi/events');
+
+    source.onmessage = function (event) {
+      try {
+        applyStatus(JSON.parse(event.data) || {});
+      } catch (e) {
+        // 忽略无法解析的帧，等待下一次推送
+      }
+    };
+
+    source.onerror = function () {
+      // CLOSED 表示浏览器不会再自动重连（如接口不存在），此时改用轮询
+      if (source.readyState === EventSource.CLOSED) {
+        startStatusPolling();
+      }
+    };
+  }
+
   /**
    * 设置“连接 WiFi”模块下方的提示信息。
    *
@@ -501,7 +613,7 @@
     if (dom.btnScan) {
       dom.btnScan.addEventListener('click', function (event) {
         event.preventDefault();
-        loadScanList();
+        loadScanList(true);
       });
     }
 
@@ -587,7 +699,7 @@
     initDom();
     renderInitialState();
     bindEvents();
-    startStatusPolling();
+    startStatusEvents();
     loadSavedList();
     loadScanList();
   }